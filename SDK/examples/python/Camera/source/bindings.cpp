@@ -2,61 +2,147 @@
 #include <pybind11/numpy.h>
 
 #include <opencv2/opencv.hpp>
-#include <cstring>   // std::memcpy
+#include <array>
+#include <string>
+#include <vector>
 
 #include "lccv.hpp"
 #include "libcamera_app_options.hpp"
 
 namespace py = pybind11;
 
-// Convert cv::Mat -> numpy array (COPY for safety; avoids libcamera buffer lifetime issues)
-static py::array mat_to_numpy_copy(const cv::Mat& mat)
+// Frame buffers reused across capture calls. A numpy array returned to Python is a
+// view of a slot's cv::Mat; the capsule holds a cv::Mat reference, so the slot is
+// only reused once Python dropped every array that points into it (refcount == 1).
+static constexpr size_t FRAME_POOL_SIZE = 4;
+
+class FramePool
 {
-    if (mat.empty() || mat.cols <= 0 || mat.rows <= 0)
-        return py::array();
+public:
+    // Pick a free slot (GIL held). Returns -1 if all slots are referenced from Python.
+    int acquire()
+    {
+        for (size_t i = 0; i < FRAME_POOL_SIZE; i++)
+        {
+            Slot& slot = slots[i];
+            if (!slot.busy && (slot.mat.empty() || slot.mat.u == nullptr || slot.mat.u->refcount == 1))
+            {
+                slot.busy = true;
+                return (int)i;
+            }
+        }
+        return -1;
+    }
 
-    cv::Mat src = mat;
-    if (!src.isContinuous())
-        src = src.clone();
+    cv::Mat& mat(int index) { return slots[index].mat; }
 
-    const int h = src.rows;
-    const int w = src.cols;
-    const int ch = src.channels();
+    void release(int index) { slots[index].busy = false; }
 
-    // Only handle 8-bit images cleanly (most camera outputs here are CV_8U)
-    if (src.depth() != CV_8U)
+private:
+    struct Slot
     {
-        cv::Mat tmp;
-        src.convertTo(tmp, CV_8U);
-        src = tmp;
-    }
+        cv::Mat mat;
+        bool busy = false; // filled by a call that released the GIL
+    };
+
+    std::array<Slot, FRAME_POOL_SIZE> slots;
+};
+
+// PiCamera plus the frame pool backing the numpy arrays it returns
+struct PyPiCamera : public PiCamera
+{
+    FramePool pool;
+};
+
+// Wrap a cv::Mat as numpy array without copying; the array keeps the buffer alive.
+static py::array mat_to_numpy_view(const cv::Mat& mat)
+{
+    if (mat.empty() || mat.cols <= 0 || mat.rows <= 0 || mat.depth() != CV_8U)
+        return py::array();
+
+    auto* owner = new cv::Mat(mat); // shares the buffer, refcount + 1
+    py::capsule base(owner, [](void* p) { delete static_cast<cv::Mat*>(p); });
 
-    if (ch == 1)
+    const int ch = mat.channels();
+    std::vector<py::ssize_t> shape = { mat.rows, mat.cols };
+    std::vector<py::ssize_t> strides = { (py::ssize_t)mat.step[0], (py::ssize_t)mat.elemSize() };
+    if (ch > 1)
     {
-        auto out = py::array_t<uint8_t>({h, w});
-        std::memcpy(out.mutable_data(), src.data, (size_t)h * (size_t)w);
-        return out;
+        shape.push_back(ch);
+        strides.push_back(1);
     }
-    else if (ch == 3)
+
+    return py::array(py::dtype::of<uint8_t>(), shape, strides, owner->data, base);
+}
+
+// Wrap a caller-provided numpy array as cv::Mat header (no copy).
+static cv::Mat numpy_to_mat(py::array& out)
+{
+    if (out.dtype().kind() != 'u' || out.itemsize() != 1 || !out.writeable()
+        || (out.ndim() != 2 && out.ndim() != 3) || out.strides(out.ndim() - 1) != 1)
+        throw py::value_error("out must be a writable uint8 array of shape (h, w) or (h, w, c) with contiguous rows");
+
+    const int ch = out.ndim() == 3 ? (int)out.shape(2) : 1;
+    if (ch < 1 || ch > 4 || (out.ndim() == 3 && out.strides(1) != ch))
+        throw py::value_error("out must have 1 to 4 interleaved channels");
+
+    return cv::Mat((int)out.shape(0), (int)out.shape(1), CV_8UC(ch), out.mutable_data(), (size_t)out.strides(0));
+}
+
+static std::string shape_string(int rows, int cols, int ch)
+{
+    return "(" + std::to_string(rows) + ", " + std::to_string(cols) + ", " + std::to_string(ch) + ")";
+}
+
+// Run a capture call into a pooled buffer (zero-copy result) or into `out`.
+// rows x cols is the BGR frame size the options configure, checked before capturing.
+template <typename Capture>
+static py::object capture_frame(PyPiCamera& self, py::object out, int rows, int cols, Capture capture)
+{
+    if (!out.is_none())
     {
-        auto out = py::array_t<uint8_t>({h, w, 3});
-        std::memcpy(out.mutable_data(), src.data, (size_t)h * (size_t)w * 3);
-        return out;
+        if (!py::isinstance<py::array>(out))
+            throw py::type_error("out must be a numpy array");
+        py::array array = out.cast<py::array>();
+
+        // the camera writes straight into `out` if shape and type match the frame
+        cv::Mat frame = numpy_to_mat(array);
+        if (frame.rows != rows || frame.cols != cols || frame.channels() != 3)
+            throw py::value_error("out shape does not match the frame: expected " + shape_string(rows, cols, 3));
+        const uint8_t* target = frame.data;
+        bool ok;
+        {
+            py::gil_scoped_release r;
+            ok = capture(frame);
+        }
+        if (!ok || frame.empty())
+            return py::none();
+        if (frame.data != target)
+            throw py::value_error("out shape does not match the frame: expected "
+                + shape_string(frame.rows, frame.cols, frame.channels()));
+        return array;
     }
-    else if (ch == 4)
+
+    int slot = self.pool.acquire();
+    cv::Mat local;
+    cv::Mat& frame = slot >= 0 ? self.pool.mat(slot) : local;
+    bool ok;
     {
-        auto out = py::array_t<uint8_t>({h, w, 4});
-        std::memcpy(out.mutable_data(), src.data, (size_t)h * (size_t)w * 4);
-        return out;
+        py::gil_scoped_release r;
+        ok = capture(frame);
     }
 
-    // Unsupported channel count
-    return py::array();
+    py::object result = py::none();
+    if (ok && !frame.empty())
+        result = mat_to_numpy_view(frame);
+    if (slot >= 0)
+        self.pool.release(slot);
+    return result;
 }
 
 PYBIND11_MODULE(doly_camera, m)
 {
-    m.doc() = "Doly camera module (LCCV/libcamera) - frames returned as NumPy arrays.";
+    m.doc() = "Doly camera module (LCCV/libcamera) - frames returned as NumPy arrays (zero-copy).";
 
     // ----- Enums (optional but useful) -----
     py::enum_<Exposure_Modes>(m, "ExposureModes")
@@ -130,13 +216,13 @@ PYBIND11_MODULE(doly_camera, m)
         .def("get_white_balance", &Options::getWhiteBalance);
 
     // ----- PiCamera -----
-    py::class_<PiCamera>(m, "PiCamera")
+    py::class_<PyPiCamera>(m, "PiCamera")
         .def(py::init<>())
 
         // Expose the Options owned by PiCamera
         .def_property_readonly(
             "options",
-            [](PiCamera& self) -> Options& {
+            [](PyPiCamera& self) -> Options& {
                 return *self.options;
             },
             py::return_value_policy::reference_internal,
@@ -144,61 +230,49 @@ PYBIND11_MODULE(doly_camera, m)
         )
 
         // Photo mode
-        .def("start_photo", [](PiCamera& self) {
+        .def("start_photo", [](PyPiCamera& self) {
             py::gil_scoped_release r;
             return self.startPhoto();
         })
-        .def("capture_photo", [](PiCamera& self) -> py::object {
-            cv::Mat frame;
-            bool ok = false;
-            {
-                py::gil_scoped_release r;
-                ok = self.capturePhoto(frame);
-            }
-            if (!ok || frame.empty())
-                return py::none();
-
-            return mat_to_numpy_copy(frame); // <-- NO py::cast
-        })
-        .def("stop_photo", [](PiCamera& self) {
+        .def("capture_photo", [](PyPiCamera& self, py::object out) -> py::object {
+            const int rows = (int)self.options->photo_height, cols = (int)self.options->photo_width;
+            return capture_frame(self, out, rows, cols, [&self](cv::Mat& frame) {
+                return self.capturePhoto(frame);
+            });
+        }, py::arg("out") = py::none())
+        .def("stop_photo", [](PyPiCamera& self) {
             py::gil_scoped_release r;
             return self.stopPhoto();
         })
 
         // Video mode
-        .def("start_video", [](PiCamera& self) {
+        .def("start_video", [](PyPiCamera& self) {
             py::gil_scoped_release r;
             return self.startVideo();
         })
-        .def("get_video_frame", [](PiCamera& self, unsigned int timeout_ms) -> py::object {
-            cv::Mat frame;
-            bool ok = false;
-            {
-                py::gil_scoped_release r;
-                ok = self.getVideoFrame(frame, timeout_ms);
-            }
-            if (!ok || frame.empty())
-                return py::none();
-
-            return mat_to_numpy_copy(frame); // <-- NO py::cast
-        }, py::arg("timeout_ms") = 1500)
-        .def("stop_video", [](PiCamera& self) {
+        .def("get_video_frame", [](PyPiCamera& self, unsigned int timeout_ms, py::object out) -> py::object {
+            const int rows = (int)self.options->video_height, cols = (int)self.options->video_width;
+            return capture_frame(self, out, rows, cols, [&self, timeout_ms](cv::Mat& frame) {
+                return self.getVideoFrame(frame, timeout_ms);
+            });
+        }, py::arg("timeout_ms") = 1500, py::arg("out") = py::none())
+        .def("stop_video", [](PyPiCamera& self) {
             py::gil_scoped_release r;
             self.stopVideo();
         })
 
         // Apply zoom (ROI) after updating options->roi_*
-        .def("apply_zoom_options", [](PiCamera& self) {
+        .def("apply_zoom_options", [](PyPiCamera& self) {
             py::gil_scoped_release r;
             self.ApplyZoomOptions();
         })
 
         // Custom controls
-        .def("set_exposure", [](PiCamera& self, float value) {
+        .def("set_exposure", [](PyPiCamera& self, float value) {
             py::gil_scoped_release r;
             self.SetExposure(value);
         }, py::arg("value"))
-        .def("set_awb_enable", [](PiCamera& self, bool enable) {
+        .def("set_awb_enable", [](PyPiCamera& self, bool enable) {
             py::gil_scoped_release r;
             self.SetAwbEnable(enable);
         }, py::arg("enable"));
@@ -0,0 +1,309 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @file BoundedQueue.h
+ * @brief Bounded FIFO with a drop/backpressure policy and depth counters.
+ *
+ * Used between pipeline stages that must not grow without bound, e.g. camera
+ * requests between PiCameraStream's capture and processing threads: a dropped
+ * CompletedRequestPtr is destroyed right away, which hands its buffers back to the
+ * camera instead of starving it.
+ *
+ * Design notes:
+ * - Array of cells with a per-cell sequence number (Vyukov): push() and pop() are
+ *   lock-free, a cell is only reused after its reader has moved the item out
+ * - Any number of producers and consumers; single producer / single consumer is the
+ *   fast case, with no contention on either index
+ * - DROP_OLDEST pops and destroys the oldest item to make room, DROP_NEWEST refuses
+ *   the new item, BLOCK waits for room
+ * - Exact capacity, not rounded to a power of two; capacity 1 uses two cells (a cell
+ *   sequence can not tell "full" from "free for the next lap" with one) and checks
+ *   the depth on push
+ *
+ * Threading notes:
+ * - configure() must not run concurrently with any other call
+ * - Waiting threads sleep on a condition variable; the other side only touches its
+ *   mutex when someone is actually waiting
+ *
+ * @ingroup doly_sdk_common
+ */
+
+/** @brief What a full queue does with a new item. */
+enum class DropPolicy : uint8_t
+{
+	DROP_OLDEST,	// destroy the oldest queued item (keep the newest)
+	DROP_NEWEST,	// refuse the new item (keep a gapless start)
+	BLOCK,			// wait until there is room
+};
+
+template <typename T>
+class BoundedQueue
+{
+	struct Cell
+	{
+		std::atomic<size_t> sequence{ 0 };
+		T value{};
+	};
+
+public:
+	explicit BoundedQueue(size_t capacity = 1, DropPolicy policy = DropPolicy::DROP_OLDEST) { configure(capacity, policy); }
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	/**
+	 * @brief Drop all items, reset the counters and reopen the queue.
+	 *
+	 * @param capacity Maximum number of queued items (at least 1).
+	 * @param policy What push() does when the queue is full.
+	 */
+	void configure(size_t capacity, DropPolicy policy)
+	{
+		limit = std::max<size_t>(capacity, 1);
+		cell_count = std::max<size_t>(limit, 2);
+		cells = std::make_unique<Cell[]>(cell_count);
+		for (size_t i = 0; i < cell_count; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		drop_policy = policy;
+		head.store(0);
+		tail.store(0);
+		pushed_items.store(0);
+		dropped_items.store(0);
+		max_depth.store(0);
+		closed.store(false);
+	}
+
+	size_t capacity() const { return limit; }
+	DropPolicy policy() const { return drop_policy; }
+
+	/** @brief Items queued right now (approximate while others push or pop). */
+	size_t size() const
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		const size_t t = tail.load(std::memory_order_relaxed);
+		return t > h ? std::min(t - h, limit) : 0;
+	}
+
+	bool empty() const { return size() == 0; }
+
+	/** @brief Items accepted by push(). */
+	uint64_t pushed() const { return pushed_items.load(std::memory_order_relaxed); }
+
+	/** @brief Items dropped by the policy (oldest destroyed, or newest refused). */
+	uint64_t dropped() const { return dropped_items.load(std::memory_order_relaxed); }
+
+	/** @brief Highest depth seen since configure(). */
+	size_t maxDepth() const { return max_depth.load(std::memory_order_relaxed); }
+
+	bool isClosed() const { return closed.load(); }
+
+	// ---------------------------------------------------------------- producer
+
+	/**
+	 * @brief Queue an item, applying the policy when the queue is full.
+	 *
+	 * @return True if queued; false if refused (DROP_NEWEST) or the queue is closed.
+	 *         The item is left untouched when refused.
+	 */
+	bool push(T&& item)
+	{
+		if (closed.load())
+			return false;
+
+		while (!tryPush(item))
+		{
+			if (closed.load())
+				return false;
+
+			if (drop_policy == DropPolicy::DROP_NEWEST)
+			{
+				dropped_items.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			if (drop_policy == DropPolicy::DROP_OLDEST)
+			{
+				T oldest;
+				if (take(oldest))
+					dropped_items.fetch_add(1, std::memory_order_relaxed);
+				else
+					std::this_thread::yield();	// a reader is still moving out the cell we need
+				continue;
+			}
+
+			waitFor([this] { return size() < limit || closed.load(); }, -1);
+		}
+
+		pushed_items.fetch_add(1, std::memory_order_relaxed);
+		const size_t depth = size();
+		size_t prev = max_depth.load(std::memory_order_relaxed);
+		while (prev < depth && !max_depth.compare_exchange_weak(prev, depth, std::memory_order_relaxed))
+		{
+		}
+		wake();
+		return true;
+	}
+
+	bool push(const T& item)
+	{
+		T copy(item);
+		return push(std::move(copy));
+	}
+
+	/**
+	 * @brief Refuse further items and wake every waiting thread.
+	 *
+	 * Items already queued can still be popped.
+	 */
+	void close()
+	{
+		closed.store(true);
+		std::lock_guard<std::mutex> lk(mtx);
+		cond.notify_all();
+	}
+
+	// ---------------------------------------------------------------- consumer
+
+	/**
+	 * @brief Take the oldest item without waiting.
+	 *
+	 * @return True if an item was taken.
+	 */
+	bool tryPop(T& item)
+	{
+		if (!take(item))
+			return false;
+		if (drop_policy == DropPolicy::BLOCK)
+			wake();
+		return true;
+	}
+
+	/**
+	 * @brief Take the oldest item, waiting for one if the queue is empty.
+	 *
+	 * @param timeout_ms Maximum wait, < 0 = until an item arrives or the queue is closed.
+	 *
+	 * @return True if an item was taken; false on timeout, or if the queue is closed
+	 *         and empty.
+	 */
+	bool pop(T& item, int timeout_ms = -1)
+	{
+		if (tryPop(item))
+			return true;
+
+		bool taken = false;
+		waitFor([&] { return (taken = take(item)) || closed.load(); }, timeout_ms);
+		if (taken && drop_policy == DropPolicy::BLOCK)
+			wake();
+		return taken || tryPop(item);
+	}
+
+	/** @brief Destroy every queued item. */
+	void clear()
+	{
+		T item;
+		while (tryPop(item))
+		{
+		}
+	}
+
+private:
+	// pop without waking a blocked producer (callers may hold mtx)
+	bool take(T& item)
+	{
+		size_t pos = head.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos % cell_count];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = head.load(std::memory_order_relaxed);
+		}
+
+		item = std::move(cell->value);
+		cell->value = T();
+		cell->sequence.store(pos + cell_count, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPush(T& item)
+	{
+		size_t pos = tail.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos % cell_count];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (limit < cell_count && pos - head.load(std::memory_order_acquire) >= limit)
+					return false;
+				if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = tail.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::move(item);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// the waiter count is raised before the predicate is checked and read with an RMW
+	// after every push/pop: either the waker sees the waiter, or the waiter's RMW reads
+	// the waker's and so sees its item
+	template <typename Pred>
+	void waitFor(Pred pred, int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		waiters.fetch_add(1, std::memory_order_seq_cst);
+		if (timeout_ms < 0)
+			cond.wait(lk, pred);
+		else
+			cond.wait_for(lk, std::chrono::milliseconds(timeout_ms), pred);
+		waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void wake()
+	{
+		if (waiters.fetch_add(0, std::memory_order_seq_cst) == 0)
+			return;
+		std::lock_guard<std::mutex> lk(mtx);
+		cond.notify_all();
+	}
+
+	std::unique_ptr<Cell[]> cells;
+	size_t cell_count = 0;
+	size_t limit = 0;	// capacity
+	DropPolicy drop_policy = DropPolicy::DROP_OLDEST;
+	std::atomic<size_t> head{ 0 };
+	std::atomic<size_t> tail{ 0 };
+	std::atomic<uint64_t> pushed_items{ 0 };
+	std::atomic<uint64_t> dropped_items{ 0 };
+	std::atomic<size_t> max_depth{ 0 };
+	std::atomic<bool> closed{ false };
+
+	std::mutex mtx;
+	std::condition_variable cond;
+	std::atomic<int> waiters{ 0 };
+};
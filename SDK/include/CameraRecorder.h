@@ -0,0 +1,694 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "BoundedQueue.h"
+#include "PiCameraStream.h"
+#include "YuvKernels.h"
+
+/**
+ * @file CameraRecorder.h
+ * @brief Records PiCameraStream video to disk without stalling capture.
+ *
+ * Pipeline, one thread per stage:
+ * - intake  : copies each new ring frame into a bounded frame queue (BoundedQueue.h);
+ *             a full queue drops a frame by the drop policy, BLOCK makes intake wait
+ *             and the frames are then lost in the ring instead (dropped_ring)
+ * - encoder : JPEG into an MJPEG AVI (default), or raw YUV420 (I420) frames
+ * - writer  : collects encoded data in large aligned blocks and writes whole blocks
+ *
+ * The capture thread only feeds the frame ring (see FrameRing.h) and never waits for
+ * any stage. The writer queue is bounded too: when the disk falls behind, the encoder
+ * waits, the frame queue fills and frames are dropped at intake.
+ *
+ * Files: `<directory>/<prefix>_<YYYYmmdd_HHMMSS>_<segment>.avi`, or `..._<W>x<H>.yuv`
+ * for raw frames (play with `ffplay -f rawvideo -pixel_format yuv420p -video_size WxH`).
+ *
+ * Design notes:
+ * - AVI: one MJPG stream with an idx1 index; the header is rewritten on close with the
+ *   final sizes. Frames lost before the encoder are written as empty chunks (players
+ *   repeat the previous frame), so the clip keeps its real-time length
+ * - AVI segments are closed before 1 GiB (AVI 1.0 limit) and after segment_seconds
+ * - GREY frames are encoded as greyscale JPEG / Y plane with neutral chroma
+ * - stop() drains the queues, so every frame taken in before stop() is written
+ *
+ * @ingroup doly_sdk_common
+ */
+
+enum class RecordFormat : uint8_t
+{
+	MJPEG_AVI,
+	RAW_YUV420,
+};
+
+struct CameraRecorderOptions
+{
+	RecordFormat format = RecordFormat::MJPEG_AVI;
+	std::string directory = "/home/pi/recordings";
+	std::string prefix = "clip";
+	size_t queue_frames = 16;				// frame queue depth
+	DropPolicy drop_policy = DropPolicy::DROP_OLDEST;	// for a full frame queue
+	uint8_t jpeg_quality = 80;
+	uint32_t segment_seconds = 60;			// 0 = one file (AVI still splits before 1 GiB)
+	size_t write_block = 1 << 20;			// bytes per write, multiple of 4096
+	size_t writer_queue_bytes = 64 << 20;	// encoded data waiting for the disk
+};
+
+/** @brief CameraRecorder counters. */
+struct CameraRecorderStats
+{
+	uint64_t frames_in = 0;			// frames taken from the ring
+	uint64_t frames_encoded = 0;
+	uint64_t dropped_queue = 0;		// dropped by the drop policy (queue full)
+	uint64_t dropped_ring = 0;		// overwritten in the ring before intake
+	size_t queue_depth = 0;			// frames waiting for the encoder
+	size_t max_queue_depth = 0;
+	size_t writer_bytes = 0;		// encoded bytes waiting for the disk
+	float encoded_fps = 0;
+	uint64_t bytes_written = 0;
+	uint32_t segments = 0;
+	uint32_t write_errors = 0;
+};
+
+class CameraRecorder
+{
+	struct Frame
+	{
+		std::vector<uint8_t> data;
+		FrameStamp stamp;
+	};
+
+	enum class ChunkType : uint8_t
+	{
+		OPEN,
+		DATA,
+		PATCH,	// write at an offset, after all data
+		CLOSE,
+	};
+
+	struct Chunk
+	{
+		ChunkType type;
+		std::string path;
+		uint64_t offset = 0;
+		std::vector<uint8_t> bytes;
+	};
+
+	static constexpr size_t AVI_HEADER_BYTES = 224;
+	static constexpr uint64_t AVI_MAX_BYTES = 1000ull << 20;
+
+public:
+	explicit CameraRecorder(PiCameraStream& camera, const CameraRecorderOptions& options = CameraRecorderOptions())
+		: camera(camera), options(options)
+	{
+	}
+
+	CameraRecorder(const CameraRecorder&) = delete;
+	CameraRecorder& operator=(const CameraRecorder&) = delete;
+	~CameraRecorder() { stop(); }
+
+	/**
+	 * @brief Start recording the frames published from now on.
+	 *
+	 * @return Status code:
+	 * - 0 : success
+	 * - -1 : already recording
+	 * - -2 : camera video is not running
+	 * - -3 : output directory can not be created
+	 */
+	int8_t start()
+	{
+		if (recording.load())
+			return -1;
+		if (!camera.isStreaming())
+			return -2;
+
+		std::error_code ec;
+		std::filesystem::create_directories(options.directory, ec);
+		if (!std::filesystem::is_directory(options.directory, ec))
+			return -3;
+
+		width = camera.videoWidth();
+		height = camera.videoHeight();
+		format = camera.frameFormat();
+		if (options.format == RecordFormat::RAW_YUV420 && format != FrameFormat::YUV420)
+		{
+			width &= ~1u;
+			height &= ~1u;
+		}
+
+		const size_t depth = std::max<size_t>(options.queue_frames, 1);
+		pool.assign(depth, Frame());
+		for (auto& frame : pool)
+			frame.data.resize(camera.frames().frameBytes());
+		free_frames.configure(depth, DropPolicy::DROP_NEWEST);
+		queued.configure(depth, DropPolicy::DROP_NEWEST);
+		for (size_t i = 0; i < depth; i++)
+			free_frames.push(i);
+		{
+			std::lock_guard<std::mutex> lk(chunk_mtx);
+			chunks.clear();
+			chunk_bytes = 0;
+			bytes_written = 0;
+			write_errors = 0;
+		}
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			stats_data = CameraRecorderStats();
+		}
+		session = timeString();
+
+		recording.store(true);
+		encoder_done = false;
+		writer_thread = std::thread([this] { writeLoop(); });
+		encoder_thread = std::thread([this] { encodeLoop(); });
+		intake_thread = std::thread([this] { intakeLoop(); });
+		return 0;
+	}
+
+	/**
+	 * @brief Stop taking frames, write everything queued and close the file.
+	 */
+	void stop()
+	{
+		if (!recording.exchange(false))
+			return;
+
+		intake_thread.join();
+		queued.close();
+		encoder_thread.join();
+		{
+			std::lock_guard<std::mutex> lk(chunk_mtx);
+			encoder_done = true;
+		}
+		chunk_cond.notify_all();
+		writer_thread.join();
+	}
+
+	bool isRecording() const { return recording.load(); }
+
+	CameraRecorderStats stats() const
+	{
+		CameraRecorderStats s;
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			s = stats_data;
+		}
+		s.queue_depth = queued.size();
+		s.max_queue_depth = queued.maxDepth();
+		std::lock_guard<std::mutex> lk(chunk_mtx);
+		s.writer_bytes = chunk_bytes;
+		s.bytes_written = bytes_written;
+		s.write_errors = write_errors;
+		return s;
+	}
+
+private:
+	// ------------------------------------------------------------------ intake
+
+	void intakeLoop()
+	{
+		const FrameRing& ring = camera.frames();
+		uint64_t after = ring.latestSeq();
+		while (recording.load())
+		{
+			FrameRing::Ref ref = ring.next(after, 100);
+			if (!ref)
+			{
+				// a stopped camera's ring returns at once
+				if (!camera.isStreaming())
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				stats_data.frames_in++;
+				if (after != 0 && ref.seq() > after + 1)
+					stats_data.dropped_ring += ref.seq() - after - 1;
+			}
+			after = ref.seq();
+
+			// the encoder holds at most one slot, the others are free or queued
+			size_t slot;
+			bool have = free_frames.tryPop(slot);
+			if (!have && options.drop_policy == DropPolicy::DROP_OLDEST)
+			{
+				have = queued.tryPop(slot);	// reuse the oldest queued frame
+				countDrop();
+			}
+			else if (!have && options.drop_policy == DropPolicy::BLOCK)
+			{
+				while (!have && recording.load())
+					have = free_frames.pop(slot, 100);
+			}
+			else if (!have)
+				countDrop();
+			if (!have)
+				continue;
+
+			// the slot is owned by intake until queued
+			Frame& frame = pool[slot];
+			memcpy(frame.data.data(), ref.data(), std::min(frame.data.size(), ref.size()));
+			frame.stamp = ref.stamp();
+			ref.release();
+			queued.push(slot);
+		}
+	}
+
+	// ----------------------------------------------------------------- encoder
+
+	void encodeLoop()
+	{
+		std::vector<uint8_t> jpeg;
+		cv::Mat bgr;
+		uint64_t last_seq = 0;
+		int64_t last_encoded = 0;
+		float avg_interval = 0;
+
+		while (true)
+		{
+			size_t slot;
+			if (!queued.pop(slot))
+				break;
+
+			const Frame& frame = pool[slot];
+			if (!segment_open || segmentFull(frame.stamp.timestamp_ns))
+			{
+				closeSegment();
+				openSegment(frame.stamp.timestamp_ns);
+			}
+
+			if (options.format == RecordFormat::MJPEG_AVI)
+			{
+				// empty chunks keep the timeline across lost frames
+				if (last_seq != 0 && frame.stamp.seq > last_seq + 1)
+				{
+					for (uint64_t i = std::min<uint64_t>(frame.stamp.seq - last_seq - 1, 300); i > 0; i--)
+						writeAviFrame(nullptr, 0);
+				}
+				encodeJpeg(frame, bgr, jpeg);
+				writeAviFrame(jpeg.data(), jpeg.size());
+			}
+			else
+				writeYuvFrame(frame);
+			last_seq = frame.stamp.seq;
+
+			free_frames.push(slot);
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				stats_data.frames_encoded++;
+				const int64_t now = PiCameraStream::clockNs();
+				if (last_encoded != 0)
+				{
+					const float dt = (now - last_encoded) / 1e9f;
+					avg_interval = avg_interval == 0 ? dt : avg_interval * 0.9f + dt * 0.1f;
+					stats_data.encoded_fps = avg_interval > 0 ? 1.0f / avg_interval : 0;
+				}
+				last_encoded = now;
+			}
+		}
+		closeSegment();
+	}
+
+	void encodeJpeg(const Frame& frame, cv::Mat& bgr, std::vector<uint8_t>& jpeg)
+	{
+		uint8_t* data = const_cast<uint8_t*>(frame.data.data());
+		cv::Mat src;
+		if (format == FrameFormat::YUV420)
+		{
+			PiCameraStream::toBgr(cv::Mat(height * 3 / 2, width, CV_8UC1, data), format, bgr);
+			src = bgr;
+		}
+		else
+			src = cv::Mat(height, width, format == FrameFormat::BGR ? CV_8UC3 : CV_8UC1, data);
+		if (!cv::imencode(".jpg", src, jpeg, { cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality }))
+			jpeg.clear();
+	}
+
+	void writeYuvFrame(const Frame& frame)
+	{
+		const size_t y_bytes = (size_t)width * height;
+		std::vector<uint8_t> out(y_bytes * 3 / 2);
+		uint8_t* u = out.data() + y_bytes;
+		uint8_t* v = u + y_bytes / 4;
+		const uint8_t* src = frame.data.data();
+		if (format == FrameFormat::YUV420)
+			memcpy(out.data(), src, out.size());
+		else if (format == FrameFormat::GREY)
+		{
+			YuvKernels::copyPlane(src, camera.videoWidth(), out.data(), width, width, height);
+			memset(u, 128, y_bytes / 2);
+		}
+		else
+			YuvKernels::bgrToI420(src, (size_t)camera.videoWidth() * 3, out.data(), width, u, v, width / 2, width, height);
+
+		segment_bytes += out.size();
+		pushChunk({ ChunkType::DATA, "", 0, std::move(out) });
+	}
+
+	bool segmentFull(int64_t timestamp_ns) const
+	{
+		if (options.segment_seconds != 0 && timestamp_ns - segment_start >= (int64_t)options.segment_seconds * 1000000000)
+			return true;
+		return options.format == RecordFormat::MJPEG_AVI && segment_bytes >= AVI_MAX_BYTES;
+	}
+
+	void openSegment(int64_t timestamp_ns)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "_%03u", segment_index++);
+		std::string path = options.directory + "/" + options.prefix + "_" + session + name;
+		if (options.format == RecordFormat::MJPEG_AVI)
+			path += ".avi";
+		else
+			path += "_" + std::to_string(width) + "x" + std::to_string(height) + ".yuv";
+
+		pushChunk({ ChunkType::OPEN, path, 0, {} });
+		segment_open = true;
+		segment_start = timestamp_ns;
+		segment_bytes = 0;
+		avi_frames = 0;
+		avi_max_chunk = 0;
+		avi_index.clear();
+		if (options.format == RecordFormat::MJPEG_AVI)
+		{
+			// placeholder, rewritten by closeSegment()
+			segment_bytes = AVI_HEADER_BYTES;
+			pushChunk({ ChunkType::DATA, "", 0, aviHeader(false) });
+		}
+
+		std::lock_guard<std::mutex> lk(mtx);
+		stats_data.segments++;
+	}
+
+	void closeSegment()
+	{
+		if (!segment_open)
+			return;
+
+		if (options.format == RecordFormat::MJPEG_AVI)
+		{
+			std::vector<uint8_t> index;
+			appendFourcc(index, "idx1");
+			append32(index, (uint32_t)avi_index.size());
+			index.insert(index.end(), avi_index.begin(), avi_index.end());
+			segment_bytes += index.size();
+			pushChunk({ ChunkType::DATA, "", 0, std::move(index) });
+			pushChunk({ ChunkType::PATCH, "", 0, aviHeader(true) });
+		}
+		pushChunk({ ChunkType::CLOSE, "", 0, {} });
+		segment_open = false;
+	}
+
+	// ---------------------------------------------------------------- AVI
+
+	static void append32(std::vector<uint8_t>& v, uint32_t x)
+	{
+		for (int i = 0; i < 4; i++)
+			v.push_back((uint8_t)(x >> (8 * i)));
+	}
+
+	static void append16(std::vector<uint8_t>& v, uint16_t x)
+	{
+		v.push_back((uint8_t)x);
+		v.push_back((uint8_t)(x >> 8));
+	}
+
+	static void appendFourcc(std::vector<uint8_t>& v, const char* fourcc) { v.insert(v.end(), fourcc, fourcc + 4); }
+
+	void writeAviFrame(const uint8_t* jpeg, size_t size)
+	{
+		std::vector<uint8_t> chunk;
+		chunk.reserve(size + 9);
+		appendFourcc(chunk, "00dc");
+		append32(chunk, (uint32_t)size);
+		if (size != 0)
+			chunk.insert(chunk.end(), jpeg, jpeg + size);
+		if (size & 1)
+			chunk.push_back(0);
+
+		// idx1 offsets count from the 'movi' fourcc
+		appendFourcc(avi_index, "00dc");
+		append32(avi_index, size != 0 ? 0x10 : 0);
+		append32(avi_index, (uint32_t)(segment_bytes - (AVI_HEADER_BYTES - 4)));
+		append32(avi_index, (uint32_t)size);
+
+		segment_bytes += chunk.size();
+		avi_frames++;
+		avi_max_chunk = std::max(avi_max_chunk, (uint32_t)size);
+		pushChunk({ ChunkType::DATA, "", 0, std::move(chunk) });
+	}
+
+	// RIFF/hdrl/strl headers and the movi list header, AVI_HEADER_BYTES long;
+	// final = after idx1, with the real sizes
+	std::vector<uint8_t> aviHeader(bool final) const
+	{
+		const float fps = camera.options->framerate > 0 ? camera.options->framerate : 30.0f;
+		const uint32_t rate = (uint32_t)(fps * 1000);
+		const uint64_t movi_end = segment_bytes - avi_index.size() - 8;
+
+		std::vector<uint8_t> h;
+		h.reserve(AVI_HEADER_BYTES);
+		appendFourcc(h, "RIFF");
+		append32(h, final ? (uint32_t)(segment_bytes - 8) : 0);
+		appendFourcc(h, "AVI ");
+
+		appendFourcc(h, "LIST");
+		append32(h, 4 + 64 + 12 + 64 + 48);
+		appendFourcc(h, "hdrl");
+
+		appendFourcc(h, "avih");
+		append32(h, 56);
+		append32(h, (uint32_t)(1e6f / fps));				// dwMicroSecPerFrame
+		append32(h, 0);										// dwMaxBytesPerSec
+		append32(h, 0);										// dwPaddingGranularity
+		append32(h, 0x10);									// AVIF_HASINDEX
+		append32(h, avi_frames);							// dwTotalFrames
+		append32(h, 0);										// dwInitialFrames
+		append32(h, 1);										// dwStreams
+		append32(h, avi_max_chunk);							// dwSuggestedBufferSize
+		append32(h, width);
+		append32(h, height);
+		for (int i = 0; i < 4; i++)
+			append32(h, 0);
+
+		appendFourcc(h, "LIST");
+		append32(h, 4 + 64 + 48);
+		appendFourcc(h, "strl");
+
+		appendFourcc(h, "strh");
+		append32(h, 56);
+		appendFourcc(h, "vids");
+		appendFourcc(h, "MJPG");
+		append32(h, 0);										// dwFlags
+		append16(h, 0);										// wPriority
+		append16(h, 0);										// wLanguage
+		append32(h, 0);										// dwInitialFrames
+		append32(h, 1000);									// dwScale
+		append32(h, rate);									// dwRate (frames per 1000 s)
+		append32(h, 0);										// dwStart
+		append32(h, avi_frames);							// dwLength
+		append32(h, avi_max_chunk);							// dwSuggestedBufferSize
+		append32(h, 0xffffffffu);							// dwQuality
+		append32(h, 0);										// dwSampleSize
+		append16(h, 0);										// rcFrame
+		append16(h, 0);
+		append16(h, (uint16_t)width);
+		append16(h, (uint16_t)height);
+
+		appendFourcc(h, "strf");
+		append32(h, 40);
+		append32(h, 40);									// biSize
+		append32(h, width);
+		append32(h, height);
+		append16(h, 1);										// biPlanes
+		append16(h, format == FrameFormat::GREY ? 8 : 24);	// biBitCount
+		appendFourcc(h, "MJPG");
+		append32(h, width * height * 3);					// biSizeImage
+		for (int i = 0; i < 4; i++)
+			append32(h, 0);
+
+		appendFourcc(h, "LIST");
+		append32(h, final ? (uint32_t)(movi_end - (AVI_HEADER_BYTES - 4)) : 4);
+		appendFourcc(h, "movi");
+		return h;
+	}
+
+	// ------------------------------------------------------------------ writer
+
+	// blocks while the writer queue is full (encoder side only)
+	void pushChunk(Chunk&& chunk)
+	{
+		std::unique_lock<std::mutex> lk(chunk_mtx);
+		chunk_cond.wait(lk, [&] { return chunk_bytes < options.writer_queue_bytes || chunks.empty(); });
+		chunk_bytes += chunk.bytes.size();
+		chunks.push_back(std::move(chunk));
+		lk.unlock();
+		chunk_cond.notify_all();
+	}
+
+	void writeLoop()
+	{
+		const size_t block_size = std::max<size_t>(options.write_block & ~size_t(4095), 4096);
+		void* memory = nullptr;
+		if (posix_memalign(&memory, 4096, block_size) != 0)
+			memory = nullptr;
+		std::unique_ptr<uint8_t, decltype(&free)> block(static_cast<uint8_t*>(memory), &free);
+		size_t fill = 0;
+		int fd = -1;
+
+		while (true)
+		{
+			Chunk chunk;
+			{
+				std::unique_lock<std::mutex> lk(chunk_mtx);
+				chunk_cond.wait(lk, [this] { return !chunks.empty() || encoder_done; });
+				if (chunks.empty())
+					break;
+				chunk = std::move(chunks.front());
+				chunks.pop_front();
+				chunk_bytes -= chunk.bytes.size();
+			}
+			chunk_cond.notify_all();
+
+			switch (chunk.type)
+			{
+			case ChunkType::OPEN:
+				fd = open(chunk.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+				if (fd < 0)
+					countError();
+				fill = 0;
+				break;
+
+			case ChunkType::DATA:
+			{
+				size_t done = 0;
+				while (block && done < chunk.bytes.size())
+				{
+					const size_t n = std::min(block_size - fill, chunk.bytes.size() - done);
+					memcpy(block.get() + fill, chunk.bytes.data() + done, n);
+					fill += n;
+					done += n;
+					if (fill == block_size)
+					{
+						writeOut(fd, block.get(), fill);
+						fill = 0;
+					}
+				}
+				break;
+			}
+
+			case ChunkType::PATCH:
+				writeOut(fd, block.get(), fill);
+				fill = 0;
+				if (fd >= 0 && pwrite(fd, chunk.bytes.data(), chunk.bytes.size(), (off_t)chunk.offset) != (ssize_t)chunk.bytes.size())
+					countError();
+				break;
+
+			case ChunkType::CLOSE:
+				writeOut(fd, block.get(), fill);
+				fill = 0;
+				if (fd >= 0 && close(fd) != 0)
+					countError();
+				fd = -1;
+				break;
+			}
+		}
+
+		if (fd >= 0)
+			close(fd);
+	}
+
+	void writeOut(int fd, const uint8_t* data, size_t size)
+	{
+		if (fd < 0 || size == 0)
+			return;
+
+		size_t done = 0;
+		while (done < size)
+		{
+			ssize_t n = write(fd, data + done, size - done);
+			if (n <= 0)
+			{
+				countError();
+				return;
+			}
+			done += (size_t)n;
+		}
+		std::lock_guard<std::mutex> lk(chunk_mtx);
+		bytes_written += size;
+	}
+
+	void countDrop()
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		stats_data.dropped_queue++;
+	}
+
+	void countError()
+	{
+		std::lock_guard<std::mutex> lk(chunk_mtx);
+		write_errors++;
+	}
+
+	static std::string timeString()
+	{
+		char buf[32];
+		time_t now = time(nullptr);
+		tm local{};
+		localtime_r(&now, &local);
+		strftime(buf, sizeof(buf), "%Y%m%d_%H%M%S", &local);
+		return buf;
+	}
+
+	PiCameraStream& camera;
+	CameraRecorderOptions options;
+	std::atomic<bool> recording{ false };
+	std::thread intake_thread, encoder_thread, writer_thread;
+
+	// frame layout, fixed while recording
+	unsigned int width = 0, height = 0;
+	FrameFormat format = FrameFormat::BGR;
+
+	// frame queue: pool slots are free, queued, or owned by intake/encoder
+	std::vector<Frame> pool;
+	BoundedQueue<size_t> free_frames;
+	BoundedQueue<size_t> queued;
+	mutable std::mutex mtx;	// stats_data
+	CameraRecorderStats stats_data;
+
+	// encoder state
+	std::string session;
+	uint32_t segment_index = 0;
+	bool segment_open = false;
+	int64_t segment_start = 0;
+	uint64_t segment_bytes = 0;
+	uint32_t avi_frames = 0;
+	uint32_t avi_max_chunk = 0;
+	std::vector<uint8_t> avi_index;
+
+	// writer queue
+	mutable std::mutex chunk_mtx;
+	std::condition_variable chunk_cond;
+	std::deque<Chunk> chunks;
+	size_t chunk_bytes = 0;
+	bool encoder_done = false;
+	uint64_t bytes_written = 0;
+	uint32_t write_errors = 0;
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @file CameraReplay.h
+ * @brief Recorded frame source for PiCameraStream (replay backend).
+ *
+ * Serves BGR frames from a recording instead of the camera, so vision pipelines can
+ * be run and benchmarked deterministically without a robot:
+ * - video file : anything cv::VideoCapture opens (e.g. .mp4, .avi, .mkv)
+ * - directory  : image files (.png, .jpg, .jpeg, .bmp), in file name order
+ * - raw dump   : `.bgr` / `.raw` file of packed BGR frames back to back; the frame
+ *                size is taken from the camera options (video_width x video_height)
+ *
+ * Selected with PiCameraStream::setReplay() or the environment:
+ * - DOLY_CAMERA_REPLAY=<path>       enables replay
+ * - DOLY_CAMERA_REPLAY_FPS=<fps>    frame rate, 0 = as fast as the consumer reads
+ *                                   (default: options->framerate)
+ * - DOLY_CAMERA_REPLAY_LOOP=1       restart at the end instead of stopping
+ *
+ * Design notes:
+ * - All frames of a source have the size of the first one; differing images are resized
+ *
+ * @ingroup doly_sdk_common
+ */
+
+class CameraReplay
+{
+public:
+	enum class Source : uint8_t
+	{
+		NONE,
+		VIDEO,
+		IMAGES,
+		RAW,
+	};
+
+	CameraReplay() = default;
+	CameraReplay(const CameraReplay&) = delete;
+	CameraReplay& operator=(const CameraReplay&) = delete;
+	~CameraReplay() { close(); }
+
+	/**
+	 * @brief Open a recording and read its frame size.
+	 *
+	 * @param path Video file, image directory or raw `.bgr` / `.raw` dump.
+	 * @param raw_width Frame width of a raw dump.
+	 * @param raw_height Frame height of a raw dump.
+	 *
+	 * @return Status code:
+	 * - 0 : success
+	 * - -1 : path not found
+	 * - -2 : unsupported or empty source
+	 */
+	int8_t open(const std::string& path, unsigned int raw_width, unsigned int raw_height)
+	{
+		close();
+		std::error_code ec;
+		if (!std::filesystem::exists(path, ec))
+			return -1;
+
+		if (std::filesystem::is_directory(path, ec))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+			{
+				std::string ext = entry.path().extension().string();
+				std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+				if (entry.is_regular_file() && (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp"))
+					images.push_back(entry.path().string());
+			}
+			std::sort(images.begin(), images.end());
+			source = Source::IMAGES;
+		}
+		else if (hasExtension(path, ".bgr") || hasExtension(path, ".raw"))
+		{
+			raw = fopen(path.c_str(), "rb");
+			if (raw == nullptr || raw_width == 0 || raw_height == 0)
+			{
+				close();
+				return -2;
+			}
+			frame_width = raw_width;
+			frame_height = raw_height;
+			source = Source::RAW;
+		}
+		else
+		{
+			if (!video.open(path))
+				return -2;
+			source = Source::VIDEO;
+		}
+
+		// the first frame fixes the size
+		cv::Mat first;
+		if (!read(first))
+		{
+			close();
+			return -2;
+		}
+		frame_width = (unsigned int)first.cols;
+		frame_height = (unsigned int)first.rows;
+		rewind();
+		return 0;
+	}
+
+	void close()
+	{
+		if (raw != nullptr)
+			fclose(raw);
+		raw = nullptr;
+		video.release();
+		images.clear();
+		next_image = 0;
+		frame_width = frame_height = 0;
+		source = Source::NONE;
+	}
+
+	/**
+	 * @brief Read the next frame.
+	 *
+	 * @param frame Output BGR frame (width() x height()).
+	 *
+	 * @return True on success, false at the end of the recording.
+	 */
+	bool read(cv::Mat& frame)
+	{
+		switch (source)
+		{
+		case Source::VIDEO:
+			if (!video.read(frame) || frame.empty())
+				return false;
+			break;
+
+		case Source::IMAGES:
+			do
+			{
+				if (next_image >= images.size())
+					return false;
+				frame = cv::imread(images[next_image++], cv::IMREAD_COLOR);
+			} while (frame.empty());
+			break;
+
+		case Source::RAW:
+			frame.create(frame_height, frame_width, CV_8UC3);
+			for (unsigned int y = 0; y < frame_height; y++)
+			{
+				if (fread(frame.ptr(y), 1, (size_t)frame_width * 3, raw) != (size_t)frame_width * 3)
+					return false;
+			}
+			return true;
+
+		default:
+			return false;
+		}
+
+		if (frame_width != 0 && ((unsigned int)frame.cols != frame_width || (unsigned int)frame.rows != frame_height))
+			cv::resize(frame, frame, cv::Size(frame_width, frame_height), 0, 0, cv::INTER_AREA);
+		return true;
+	}
+
+	/**
+	 * @brief Restart at the first frame.
+	 */
+	void rewind()
+	{
+		if (source == Source::VIDEO)
+			video.set(cv::CAP_PROP_POS_FRAMES, 0);
+		else if (source == Source::RAW)
+			fseek(raw, 0, SEEK_SET);
+		next_image = 0;
+	}
+
+	bool isOpen() const { return source != Source::NONE; }
+	Source sourceType() const { return source; }
+	unsigned int width() const { return frame_width; }
+	unsigned int height() const { return frame_height; }
+
+	/**
+	 * @brief Replay path from DOLY_CAMERA_REPLAY, empty if not set.
+	 */
+	static std::string envPath()
+	{
+		const char* path = getenv("DOLY_CAMERA_REPLAY");
+		return path != nullptr ? path : "";
+	}
+
+	/**
+	 * @brief Replay frame rate from DOLY_CAMERA_REPLAY_FPS, -1 if not set.
+	 */
+	static float envFramerate()
+	{
+		const char* fps = getenv("DOLY_CAMERA_REPLAY_FPS");
+		return fps != nullptr ? (float)atof(fps) : -1.0f;
+	}
+
+	/**
+	 * @brief True if DOLY_CAMERA_REPLAY_LOOP is set to a non-zero value.
+	 */
+	static bool envLoop()
+	{
+		const char* loop = getenv("DOLY_CAMERA_REPLAY_LOOP");
+		return loop != nullptr && atoi(loop) != 0;
+	}
+
+private:
+	static bool hasExtension(const std::string& path, const char* ext)
+	{
+		std::string lower = path;
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)tolower(c); });
+		const size_t len = strlen(ext);
+		return lower.size() > len && lower.compare(lower.size() - len, len, ext) == 0;
+	}
+
+	Source source = Source::NONE;
+	cv::VideoCapture video;
+	std::vector<std::string> images;
+	size_t next_image = 0;
+	FILE* raw = nullptr;
+	unsigned int frame_width = 0, frame_height = 0;
+};
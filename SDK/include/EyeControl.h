@@ -1,5 +1,7 @@
 #pragma once
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <Color.h>
@@ -14,6 +16,8 @@
  * - Singleton-style control (namespace API; no instances)
  * - Functions require init() before use
  * - Animation lifecycle is reported asynchronously through EyeEvent/EyeEventListener
+ * - Content given as std::shared_ptr is kept alive until its slot is set again
+ *   through a std::shared_ptr overload or released (see retainContent())
  *
  * Threading notes:
  * - setAnimation() is non-blocking; animations run on an internal worker thread
@@ -156,6 +160,136 @@ namespace EyeControl
 	 */
 	int8_t setBackground(VContent* bg_image, EyeSide side);
 
+	namespace detail
+	{
+		/** @brief Content slots of retained shared handles. */
+		enum Slot :uint8_t { IRIS = 0, LID_TOP = 1, LID_BOTTOM = 2, BACKGROUND = 3 };
+
+		struct Retained
+		{
+			std::mutex mtx;
+			std::shared_ptr<const VContent> held[4][2];
+		};
+
+		inline Retained& retained()
+		{
+			static Retained instance;
+			return instance;
+		}
+
+		/**
+		 * @brief Replace the handle held for a slot and side (nullptr releases it).
+		 * @warning Caller must hold Retained::mtx.
+		 */
+		inline void holdLocked(uint8_t slot, EyeSide side, const std::shared_ptr<const VContent>& content)
+		{
+			Retained& r = retained();
+			if (side != EyeSide::RIGHT)
+				r.held[slot][0] = content;
+			if (side != EyeSide::LEFT)
+				r.held[slot][1] = content;
+		}
+
+		/**
+		 * @brief Run a setter and hold its handle under one lock.
+		 *
+		 * The handle is only replaced if the setter succeeded, so the previous content
+		 * stays alive while it is still displayed.
+		 */
+		template <typename Setter>
+		inline int8_t replace(uint8_t slot, EyeSide side, const std::shared_ptr<const VContent>& content, Setter setter)
+		{
+			std::lock_guard<std::mutex> lk(retained().mtx);
+			int8_t ret = setter();
+			if (ret == 0)
+				holdLocked(slot, side, content);
+			return ret;
+		}
+	}
+
+	/**
+	 * @brief Keep shared content alive while the eye subsystem displays it.
+	 *
+	 * Used by the std::shared_ptr overloads below: one handle is held per slot and side,
+	 * replaced by the next shared set of that slot and side. The raw pointer and preset
+	 * setters do not know about the handles; after replacing shared content with one
+	 * of them, pass nullptr here to release it.
+	 *
+	 * @param slot Content slot (0 = iris, 1 = top lid, 2 = bottom lid, 3 = background).
+	 * @param side Target eye side.
+	 * @param content Handle to hold; nullptr releases the slot.
+	 */
+	inline void retainContent(uint8_t slot, EyeSide side, const std::shared_ptr<const VContent>& content)
+	{
+		std::lock_guard<std::mutex> lk(detail::retained().mtx);
+		detail::holdLocked(slot, side, content);
+	}
+
+	/**
+	 * @brief Set iris image content from a shared handle (see VContentCache.h).
+	 *
+	 * The handle is retained until the iris of @p side is set through this overload
+	 * again or released (see retainContent()).
+	 *
+	 * @note The eye subsystem is not limited to reading the content: while displaying
+	 * an animated image it advances VContent::active_frame_id. Do not show the same
+	 * content in another slot or read its active_frame_id concurrently. (Content
+	 * from VContentCache is not created const, so this write itself is defined.)
+	 *
+	 * @param eye_image Shared iris image content.
+	 * @param side Target eye side.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : null image pointer
+	 */
+	inline int8_t setIris(const std::shared_ptr<const VContent>& eye_image, EyeSide side)
+	{
+		return detail::replace(detail::IRIS, side, eye_image,
+			[&] { return setIris(const_cast<VContent*>(eye_image.get()), side); });
+	}
+
+	/**
+	 * @brief Set eyelid image content from a shared handle (see VContentCache.h).
+	 *
+	 * The handle is retained until the lid of @p side is set through this overload
+	 * again or released (see retainContent()). The eye subsystem writes
+	 * VContent::active_frame_id (see setIris()).
+	 *
+	 * @param lid_image Shared lid image content.
+	 * @param isTop True for top lid, false for bottom lid.
+	 * @param side Target eye side.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : null image pointer
+	 */
+	inline int8_t setLid(const std::shared_ptr<const VContent>& lid_image, bool isTop, EyeSide side)
+	{
+		return detail::replace(isTop ? detail::LID_TOP : detail::LID_BOTTOM, side, lid_image,
+			[&] { return setLid(const_cast<VContent*>(lid_image.get()), isTop, side); });
+	}
+
+	/**
+	 * @brief Set background image content from a shared handle (see VContentCache.h).
+	 *
+	 * The handle is retained until the background of @p side is set through this
+	 * overload again or released (see retainContent()). The eye subsystem writes
+	 * VContent::active_frame_id (see setIris()).
+	 *
+	 * @param bg_image Shared background image content.
+	 * @param side Target eye side.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : null image pointer
+	 */
+	inline int8_t setBackground(const std::shared_ptr<const VContent>& bg_image, EyeSide side)
+	{
+		return detail::replace(detail::BACKGROUND, side, bg_image,
+			[&] { return setBackground(const_cast<VContent*>(bg_image.get()), side); });
+	}
+
 	/**
 	 * @brief Start a named eye animation (non-blocking).
 	 *
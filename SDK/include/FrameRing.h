@@ -0,0 +1,491 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @file FrameRing.h
+ * @brief Lock-free single-producer frame ring used by PiCameraStream.
+ *
+ * Holds the last N frames of a stream in fixed-size slots, each tagged with a
+ * sequence number and a capture timestamp. The capture thread writes into the oldest
+ * free slot and never waits for consumers; consumers pin a slot while they read it,
+ * so a frame can not be overwritten under a reader and no reader ever sees a torn frame.
+ *
+ * Design notes:
+ * - One producer, any number of consumers
+ * - Slot state is one atomic word: pin count, or WRITING while the producer owns it
+ * - The producer skips pinned slots; if every slot is pinned the frame is dropped
+ *   (counted in dropped()), the producer is never blocked
+ * - Sequence numbers start at 1 and increase by one per published frame
+ * - Slots belong to a generation; a Ref keeps its generation alive, so a configure()
+ *   that changes the layout retires the old slots instead of freeing them under a reader
+ * - Each slot can carry a few bytes of owner metadata next to the frame (configure()),
+ *   retired together with it
+ *
+ * Threading notes:
+ * - configure() must not run concurrently with the producer; consumers may keep using
+ *   the ring and their Refs while it runs
+ * - Consumers waiting for a new frame sleep on a condition variable; the producer
+ *   only touches its mutex when a consumer is actually waiting
+ *
+ * @ingroup doly_sdk_common
+ */
+
+/** @brief Sequence number and capture time of a ring frame. */
+struct FrameStamp
+{
+	uint64_t seq = 0;
+	int64_t timestamp_ns = 0; // CLOCK_MONOTONIC
+};
+
+class FrameRing
+{
+	struct Slot
+	{
+		std::atomic<uint32_t> state{ 0 };
+		std::atomic<uint64_t> seq{ 0 };
+		int64_t timestamp_ns = 0;
+		std::vector<uint8_t> data;
+		std::vector<uint8_t> meta;
+	};
+
+	// slots of one configure() layout, freed when the ring and every Ref moved on
+	struct Generation
+	{
+		std::unique_ptr<Slot[]> slots;
+		size_t count = 0;
+		size_t bytes = 0;
+		size_t meta_bytes = 0;
+	};
+
+	static constexpr uint32_t WRITING = 0x80000000u;
+
+public:
+	/**
+	 * @brief Pinned read-only view of one ring frame, released on destruction.
+	 */
+	class Ref
+	{
+	public:
+		Ref() = default;
+		Ref(const Ref&) = delete;
+		Ref& operator=(const Ref&) = delete;
+		Ref(Ref&& other) noexcept : slot(other.slot), gen(std::move(other.gen)) { other.slot = nullptr; }
+		Ref& operator=(Ref&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				slot = other.slot;
+				gen = std::move(other.gen);
+				other.slot = nullptr;
+			}
+			return *this;
+		}
+		~Ref() { release(); }
+
+		explicit operator bool() const { return slot != nullptr; }
+		const uint8_t* data() const { return slot->data.data(); }
+		size_t size() const { return slot->data.size(); }
+		uint64_t seq() const { return slot->seq.load(std::memory_order_relaxed); }
+		int64_t timestamp() const { return slot->timestamp_ns; }
+		FrameStamp stamp() const { return { seq(), timestamp() }; }
+
+		/** @brief Owner metadata of this frame (metaBytes() long), written before commit(). */
+		const uint8_t* meta() const { return slot->meta.data(); }
+		size_t metaSize() const { return slot->meta.size(); }
+
+		/**
+		 * @brief Another pin on the same frame; the slot is reused once every Ref is released.
+		 */
+		Ref share() const
+		{
+			if (slot == nullptr)
+				return Ref();
+			slot->state.fetch_add(1, std::memory_order_relaxed);
+			return Ref(slot, gen);
+		}
+
+		void release()
+		{
+			if (slot != nullptr)
+				slot->state.fetch_sub(1, std::memory_order_release);
+			slot = nullptr;
+			gen.reset();
+		}
+
+	private:
+		friend class FrameRing;
+		Ref(Slot* s, std::shared_ptr<Generation> g) : slot(s), gen(std::move(g)) {}
+		Slot* slot = nullptr;
+		std::shared_ptr<Generation> gen;
+	};
+
+	FrameRing() = default;
+	FrameRing(const FrameRing&) = delete;
+	FrameRing& operator=(const FrameRing&) = delete;
+
+	/**
+	 * @brief Allocate @p count slots of @p frame_bytes each and reset the ring.
+	 *
+	 * With an unchanged layout the slots are kept and only invalidated, so consumers
+	 * may keep using the ring across a stop/start. Sequence numbers must continue
+	 * from latestSeq() in that case. Otherwise a new generation of slots is allocated;
+	 * pinned frames of the old one stay readable and it is freed with its last Ref.
+	 *
+	 * @param count Number of slots (at least 1).
+	 * @param frame_bytes Size of one frame in bytes.
+	 * @param meta_bytes Size of the owner metadata kept with each frame (see Ref::meta()).
+	 */
+	void configure(size_t count, size_t frame_bytes, size_t meta_bytes = 0)
+	{
+		if (count < 1)
+			count = 1;
+
+		writing = nullptr;
+		closed.store(false);
+		if (gen && count == gen->count && frame_bytes == gen->bytes && meta_bytes == gen->meta_bytes)
+		{
+			// pinned frames stay readable until released, the rest is dropped
+			for (size_t i = 0; i < gen->count; i++)
+			{
+				Slot& s = gen->slots[i];
+				uint32_t expected = 0;
+				if (s.state.compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+				{
+					s.seq.store(0, std::memory_order_relaxed);
+					s.state.store(0, std::memory_order_release);
+				}
+			}
+			return;
+		}
+
+		auto next = std::make_shared<Generation>();
+		next->count = count;
+		next->bytes = frame_bytes;
+		next->meta_bytes = meta_bytes;
+		next->slots = std::make_unique<Slot[]>(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			next->slots[i].data.resize(frame_bytes);
+			next->slots[i].meta.resize(meta_bytes);
+		}
+
+		// Refs into the old generation keep it alive
+		std::atomic_store(&gen, std::shared_ptr<Generation>(std::move(next)));
+		last_seq.store(0);
+		dropped_frames.store(0);
+	}
+
+	size_t slotCount() const
+	{
+		auto g = current();
+		return g ? g->count : 0;
+	}
+
+	/** @brief True while any frame of the current generation is pinned by a Ref. */
+	bool pinned() const
+	{
+		auto g = current();
+		for (size_t i = 0; g && i < g->count; i++)
+		{
+			if (g->slots[i].state.load(std::memory_order_acquire) != 0)
+				return true;
+		}
+		return false;
+	}
+
+	size_t frameBytes() const
+	{
+		auto g = current();
+		return g ? g->bytes : 0;
+	}
+
+	size_t metaBytes() const
+	{
+		auto g = current();
+		return g ? g->meta_bytes : 0;
+	}
+
+	/** @brief Total memory held by the current slots (retired generations not included). */
+	size_t footprint() const
+	{
+		auto g = current();
+		return g ? g->count * g->bytes : 0;
+	}
+
+	/** @brief Frames the producer had to drop because every slot was pinned. */
+	uint64_t dropped() const { return dropped_frames.load(std::memory_order_relaxed); }
+
+	/** @brief Sequence number of the newest published frame, 0 if none. */
+	uint64_t latestSeq() const { return last_seq.load(std::memory_order_acquire); }
+
+	// ---------------------------------------------------------------- producer
+
+	/**
+	 * @brief Claim the oldest unpinned slot for writing.
+	 *
+	 * The slot's metadata may be written until commit(); readers see it through
+	 * Ref::meta() while the frame is pinned.
+	 *
+	 * @param meta Optional metadata buffer of the claimed slot (metaBytes() long).
+	 *
+	 * @return Slot buffer (frameBytes() long), or nullptr if every slot is pinned;
+	 *         the frame is then counted as dropped.
+	 */
+	uint8_t* beginWrite(uint8_t** meta = nullptr)
+	{
+		// the producer is the only thread that replaces gen, no atomic load needed
+		const size_t count = gen ? gen->count : 0;
+		for (size_t attempt = 0; attempt < count; attempt++)
+		{
+			Slot* oldest = nullptr;
+			for (size_t i = 0; i < count; i++)
+			{
+				Slot& s = gen->slots[i];
+				if (s.state.load(std::memory_order_relaxed) == 0
+					&& (oldest == nullptr || s.seq.load(std::memory_order_relaxed) < oldest->seq.load(std::memory_order_relaxed)))
+					oldest = &s;
+			}
+
+			uint32_t expected = 0;
+			if (oldest != nullptr && oldest->state.compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+			{
+				oldest->seq.store(0, std::memory_order_relaxed);
+				writing = oldest;
+				if (meta != nullptr)
+					*meta = oldest->meta.data();
+				return oldest->data.data();
+			}
+		}
+
+		dropped_frames.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	/**
+	 * @brief Publish the slot claimed by beginWrite() and wake waiting consumers.
+	 *
+	 * @param seq Sequence number, greater than the previous one.
+	 * @param timestamp_ns Capture time (CLOCK_MONOTONIC).
+	 */
+	void commit(uint64_t seq, int64_t timestamp_ns)
+	{
+		if (writing == nullptr)
+			return;
+
+		writing->timestamp_ns = timestamp_ns;
+		writing->seq.store(seq, std::memory_order_relaxed);
+		writing->state.store(0, std::memory_order_release);
+		writing = nullptr;
+
+		last_seq.store(seq, std::memory_order_seq_cst);
+		wake();
+	}
+
+	/**
+	 * @brief Wake all waiting consumers; wait() returns false afterwards.
+	 */
+	void close()
+	{
+		closed.store(true, std::memory_order_seq_cst);
+		wake();
+	}
+
+	// ---------------------------------------------------------------- consumer
+
+	/**
+	 * @brief Pin the frame with sequence number @p seq.
+	 *
+	 * @return Pinned frame, or an empty Ref if it is not (or no longer) in the ring.
+	 */
+	Ref acquire(uint64_t seq) const
+	{
+		if (seq == 0)
+			return Ref();
+
+		auto g = current();
+		return g ? acquire(g, seq) : Ref();
+	}
+
+	/**
+	 * @brief Pin the newest frame.
+	 *
+	 * @return Pinned frame, or an empty Ref if nothing was published yet.
+	 */
+	Ref acquireLatest() const
+	{
+		auto g = current();
+		for (size_t attempt = 0; g && attempt <= g->count; attempt++)
+		{
+			Ref ref = acquire(g, latestSeq());
+			if (ref)
+				return ref;
+		}
+		return Ref();
+	}
+
+	/**
+	 * @brief Pin the frame captured closest to @p timestamp_ns.
+	 *
+	 * @return Pinned frame, or an empty Ref if the ring holds no frame.
+	 */
+	Ref acquireNearest(int64_t timestamp_ns) const
+	{
+		auto g = current();
+		Ref best;
+		int64_t best_diff = 0;
+		for (size_t i = 0; g && i < g->count; i++)
+		{
+			if (g->slots[i].seq.load(std::memory_order_relaxed) == 0)
+				continue;
+
+			// timestamps are only stable while pinned
+			Ref ref = pin(g, g->slots[i]);
+			if (!ref || ref.seq() == 0)
+				continue;
+
+			int64_t diff = ref.timestamp() - timestamp_ns;
+			diff = diff < 0 ? -diff : diff;
+			if (!best || diff < best_diff)
+			{
+				best = std::move(ref);
+				best_diff = diff;
+			}
+		}
+		return best;
+	}
+
+	/**
+	 * @brief Pin the oldest frame newer than @p after.
+	 *
+	 * This is frame @p after + 1 unless the consumer fell more than slotCount()
+	 * frames behind; the seq() of the result shows how many were skipped.
+	 *
+	 * @return Pinned frame, or an empty Ref if no newer frame is in the ring.
+	 */
+	Ref acquireNext(uint64_t after) const
+	{
+		auto g = current();
+		for (size_t attempt = 0; g && attempt <= g->count; attempt++)
+		{
+			if (latestSeq() <= after)
+				return Ref();
+
+			Ref ref = acquire(g, after + 1);
+			if (ref)
+				return ref;
+
+			uint64_t best = 0;
+			for (size_t i = 0; i < g->count; i++)
+			{
+				uint64_t seq = g->slots[i].seq.load(std::memory_order_relaxed);
+				if (seq > after && (best == 0 || seq < best))
+					best = seq;
+			}
+
+			ref = best != 0 ? acquire(g, best) : Ref();
+			if (ref)
+				return ref;
+		}
+		return Ref();
+	}
+
+	/**
+	 * @brief Wait until a frame newer than @p after is published.
+	 *
+	 * @param after Sequence number already seen.
+	 * @param timeout_ms Timeout in milliseconds.
+	 *
+	 * @return True if a newer frame is available, false on timeout or close().
+	 */
+	bool wait(uint64_t after, unsigned int timeout_ms) const
+	{
+		if (latestSeq() > after)
+			return true;
+
+		waiters.fetch_add(1, std::memory_order_seq_cst);
+		std::unique_lock<std::mutex> lk(wait_mtx);
+		bool ready = cond.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] {
+			return latestSeq() > after || closed.load(std::memory_order_seq_cst);
+		});
+		lk.unlock();
+		waiters.fetch_sub(1, std::memory_order_relaxed);
+		return ready && latestSeq() > after;
+	}
+
+	/**
+	 * @brief Wait for and pin the oldest frame newer than @p after.
+	 *
+	 * @return Pinned frame, or an empty Ref on timeout or close().
+	 */
+	Ref next(uint64_t after, unsigned int timeout_ms) const
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+		while (true)
+		{
+			Ref ref = acquireNext(after);
+			if (ref)
+				return ref;
+
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			if (left.count() <= 0 || !wait(after, (unsigned int)left.count()))
+				return Ref();
+		}
+	}
+
+private:
+	std::shared_ptr<Generation> current() const { return std::atomic_load(&gen); }
+
+	static Ref pin(const std::shared_ptr<Generation>& g, Slot& s)
+	{
+		uint32_t state = s.state.load(std::memory_order_relaxed);
+		while ((state & WRITING) == 0)
+		{
+			if (s.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				return Ref(&s, g);
+		}
+		return Ref();
+	}
+
+	static Ref acquire(const std::shared_ptr<Generation>& g, uint64_t seq)
+	{
+		for (size_t i = 0; seq != 0 && i < g->count; i++)
+		{
+			Slot& s = g->slots[i];
+			if (s.seq.load(std::memory_order_relaxed) != seq)
+				continue;
+
+			Ref ref = pin(g, s);
+			if (ref && s.seq.load(std::memory_order_relaxed) == seq)
+				return ref;
+			return Ref();
+		}
+		return Ref();
+	}
+
+	void wake()
+	{
+		if (waiters.load(std::memory_order_seq_cst) == 0)
+			return;
+		{
+			std::lock_guard<std::mutex> lk(wait_mtx);
+		}
+		cond.notify_all();
+	}
+
+	std::shared_ptr<Generation> gen;	// replaced by configure(), see current()
+	Slot* writing = nullptr;
+	std::atomic<uint64_t> last_seq{ 0 };
+	std::atomic<uint64_t> dropped_frames{ 0 };
+	std::atomic<bool> closed{ false };
+
+	mutable std::atomic<int> waiters{ 0 };
+	mutable std::mutex wait_mtx;
+	mutable std::condition_variable cond;
+};
@@ -0,0 +1,511 @@
+#pragma once
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "PiCameraStream.h"
+
+/**
+ * @file MjpegServer.h
+ * @brief Local MJPEG-over-HTTP preview server fed from a PiCameraStream.
+ *
+ * One encoder thread takes the newest frame from the camera ring, encodes it to JPEG
+ * once and hands the same buffer to every connected client. The capture thread is
+ * never blocked: the encoder reads frames in place through FrameRing::Ref, and the
+ * ring skips pinned slots.
+ *
+ * Endpoints (any other path returns 404):
+ * - `/` or `/stream`  multipart/x-mixed-replace MJPEG stream (browsers, ffplay, VLC)
+ * - `/snapshot.jpg`   the next encoded frame as a single JPEG
+ *
+ * Quick test from the robot:
+ *   curl -o snap.jpg http://127.0.0.1:8080/snapshot.jpg
+ *   curl -s http://127.0.0.1:8080/stream --output - | head -c 2000000 > stream.mjpeg
+ *
+ * Design notes:
+ * - Bound to loopback by default; set MjpegServerOptions::address to "0.0.0.0" to
+ *   serve the network
+ * - Adaptive quality: the encoder measures its output bitrate and steps JPEG quality
+ *   between min_quality and quality to hold target_bitrate; at min_quality it halves
+ *   the resolution (down to 1/4), and scales back up when there is headroom
+ * - Frames are encoded only while a client is connected, and at most max_fps
+ * - Each client has its own sender thread and always gets the newest encoded frame, so
+ *   a slow client skips frames without delaying the others or the encoder
+ * - GREY frames are sent as greyscale JPEG, YUV420 frames are converted to BGR first
+ *
+ * Threading notes:
+ * - start() and stop() must be called from one thread; the PiCameraStream must be
+ *   streaming for frames to be sent and must outlive the server
+ *
+ * @ingroup doly_sdk_common
+ */
+
+struct MjpegServerOptions
+{
+	std::string address = "127.0.0.1";
+	uint16_t port = 8080;
+	uint32_t target_bitrate = 8000000;	// bits per second, 0 = fixed quality
+	uint8_t quality = 80;				// initial and maximum JPEG quality
+	uint8_t min_quality = 30;
+	float max_fps = 30.0f;				// 0 = every camera frame
+	uint8_t max_clients = 8;
+};
+
+/** @brief Encoder and client counters of an MjpegServer. */
+struct MjpegServerStats
+{
+	uint32_t clients = 0;
+	uint64_t frames_encoded = 0;
+	uint64_t bytes_sent = 0;
+	float fps = 0;				// encoded frames per second
+	float bitrate = 0;			// encoded bits per second
+	uint8_t quality = 0;		// current JPEG quality
+	float scale = 1.0f;			// current resolution scale
+};
+
+class MjpegServer
+{
+	using EncodedFrame = std::shared_ptr<const std::vector<uint8_t>>;
+
+	struct Client
+	{
+		int fd = -1;
+		std::thread thread;
+		std::atomic<bool> done{ false };
+	};
+
+public:
+	explicit MjpegServer(PiCameraStream& camera, const MjpegServerOptions& options = MjpegServerOptions())
+		: camera(camera), options(options)
+	{
+	}
+
+	MjpegServer(const MjpegServer&) = delete;
+	MjpegServer& operator=(const MjpegServer&) = delete;
+	~MjpegServer() { stop(); }
+
+	/**
+	 * @brief Open the listening socket and start the server threads.
+	 *
+	 * @return Status code:
+	 * - 0 : success
+	 * - -1 : already running
+	 * - -2 : invalid address
+	 * - -3 : socket, bind or listen failed (e.g. port in use)
+	 */
+	int8_t start()
+	{
+		if (running.load())
+			return -1;
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(options.port);
+		if (inet_pton(AF_INET, options.address.c_str(), &addr.sin_addr) != 1)
+			return -2;
+
+		listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (listen_fd < 0)
+			return -3;
+
+		int on = 1;
+		setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 8) != 0)
+		{
+			close(listen_fd);
+			listen_fd = -1;
+			return -3;
+		}
+
+		quality = options.quality;
+		scale = 1.0f;
+		latest.reset();
+		generation = 0;
+		running.store(true);
+		encoder_thread = std::thread([this] { encodeLoop(); });
+		accept_thread = std::thread([this] { acceptLoop(); });
+		return 0;
+	}
+
+	/**
+	 * @brief Disconnect all clients and stop the server.
+	 */
+	void stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			for (auto& client : clients)
+				shutdown(client.fd, SHUT_RDWR);
+		}
+		cond.notify_all();
+		accept_thread.join();
+		encoder_thread.join();
+
+		for (auto& client : clients)
+		{
+			client.thread.join();
+			close(client.fd);
+		}
+		clients.clear();
+		client_count.store(0);
+		close(listen_fd);
+		listen_fd = -1;
+	}
+
+	bool isRunning() const { return running.load(); }
+
+	/**
+	 * @brief Port the server listens on (useful with options.port = 0).
+	 */
+	uint16_t port() const
+	{
+		sockaddr_in addr{};
+		socklen_t len = sizeof(addr);
+		if (listen_fd < 0 || getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+			return 0;
+		return ntohs(addr.sin_port);
+	}
+
+	MjpegServerStats stats() const
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		MjpegServerStats s = counters;
+		s.clients = (uint32_t)client_count.load();
+		s.bytes_sent = bytes_sent.load();
+		return s;
+	}
+
+private:
+	void acceptLoop()
+	{
+		while (running.load())
+		{
+			pollfd pfd = { listen_fd, POLLIN, 0 };
+			if (poll(&pfd, 1, 200) <= 0)
+			{
+				reapClients();
+				continue;
+			}
+
+			int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+			if (fd < 0)
+				continue;
+
+			reapClients();
+			std::lock_guard<std::mutex> lk(mtx);
+			if (clients.size() >= options.max_clients || !running.load())
+			{
+				close(fd);
+				continue;
+			}
+
+			// a stalled client only blocks its own sender thread
+			timeval timeout = { 2, 0 };
+			setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+			clients.emplace_back();
+			Client& client = clients.back();
+			client.fd = fd;
+			client.thread = std::thread([this, &client] { clientLoop(client); });
+		}
+	}
+
+	void reapClients()
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		for (auto it = clients.begin(); it != clients.end();)
+		{
+			if (!it->done.load())
+			{
+				++it;
+				continue;
+			}
+			it->thread.join();
+			close(it->fd);
+			it = clients.erase(it);
+		}
+	}
+
+	void clientLoop(Client& client)
+	{
+		std::string path = readRequestPath(client.fd);
+		if (path == "/" || path == "/stream")
+			streamTo(client.fd);
+		else if (path == "/snapshot.jpg")
+			snapshotTo(client.fd);
+		else if (!path.empty())
+		{
+			static const char not_found[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+			sendAll(client.fd, not_found, sizeof(not_found) - 1);
+		}
+		client.done.store(true);
+	}
+
+	// path of the GET request line, empty on error
+	static std::string readRequestPath(int fd)
+	{
+		std::string request;
+		char buf[512];
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < 4096)
+		{
+			ssize_t n = recv(fd, buf, sizeof(buf), 0);
+			if (n <= 0)
+				return "";
+			request.append(buf, (size_t)n);
+		}
+
+		if (request.compare(0, 4, "GET ") != 0)
+			return "";
+		const size_t end = request.find_first_of(" ?\r", 4);
+		return request.substr(4, end == std::string::npos ? std::string::npos : end - 4);
+	}
+
+	bool sendAll(int fd, const void* data, size_t size)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (size > 0)
+		{
+			ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+			if (n <= 0)
+				return false;
+			p += n;
+			size -= (size_t)n;
+			bytes_sent.fetch_add((uint64_t)n, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	// wait for an encoded frame newer than @p seen, null when stopping
+	EncodedFrame waitFrame(uint64_t& seen)
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		cond.wait(lk, [&] { return !running.load() || generation > seen; });
+		if (!running.load())
+			return nullptr;
+		seen = generation;
+		return latest;
+	}
+
+	void streamTo(int fd)
+	{
+		static const char header[] = "HTTP/1.0 200 OK\r\n"
+			"Cache-Control: no-cache\r\n"
+			"Connection: close\r\n"
+			"Content-Type: multipart/x-mixed-replace; boundary=mjpegframe\r\n\r\n";
+		if (!sendAll(fd, header, sizeof(header) - 1))
+			return;
+
+		addClient();
+		uint64_t seen = currentGeneration();
+		while (EncodedFrame jpeg = waitFrame(seen))
+		{
+			const std::string part = "--mjpegframe\r\nContent-Type: image/jpeg\r\nContent-Length: "
+				+ std::to_string(jpeg->size()) + "\r\n\r\n";
+			if (!sendAll(fd, part.data(), part.size()) || !sendAll(fd, jpeg->data(), jpeg->size())
+				|| !sendAll(fd, "\r\n", 2))
+				break;
+		}
+		client_count.fetch_sub(1);
+	}
+
+	void snapshotTo(int fd)
+	{
+		addClient();
+		uint64_t seen = currentGeneration();
+		EncodedFrame jpeg = waitFrame(seen);
+		client_count.fetch_sub(1);
+		if (!jpeg)
+			return;
+
+		const std::string header = "HTTP/1.0 200 OK\r\nCache-Control: no-cache\r\nConnection: close\r\n"
+			"Content-Type: image/jpeg\r\nContent-Length: " + std::to_string(jpeg->size()) + "\r\n\r\n";
+		if (sendAll(fd, header.data(), header.size()))
+			sendAll(fd, jpeg->data(), jpeg->size());
+	}
+
+	// under mtx: the idle encoder must not miss the wakeup between its check and its wait
+	void addClient()
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			client_count.fetch_add(1);
+		}
+		cond.notify_all();
+	}
+
+	uint64_t currentGeneration() const
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		return generation;
+	}
+
+	void encodeLoop()
+	{
+		const FrameRing& ring = camera.frames();
+		const std::chrono::nanoseconds interval(options.max_fps > 0 ? (int64_t)(1e9 / options.max_fps) : 0);
+		auto due = std::chrono::steady_clock::now();
+		auto last_encoded = due;
+		bool first = true;
+		uint64_t after = 0;
+		float avg_bytes = 0, avg_interval = 0;
+		int settle = 0;
+		cv::Mat converted, scaled;
+		std::vector<uint8_t> jpeg;
+
+		while (running.load())
+		{
+			// idle without clients
+			{
+				std::unique_lock<std::mutex> lk(mtx);
+				cond.wait(lk, [this] { return !running.load() || client_count.load() > 0; });
+			}
+			if (!running.load())
+				break;
+
+			FrameRing::Ref ref = ring.next(after, 200);
+			if (!ref)
+			{
+				// a stopped camera's ring returns at once
+				if (!camera.isStreaming())
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				continue;
+			}
+			after = ref.seq();
+
+			auto now = std::chrono::steady_clock::now();
+			if (interval.count() > 0)
+			{
+				if (now < due)
+					continue;
+				due = std::max(due + interval, now - interval);
+			}
+
+			// encode straight from the pinned ring slot when possible
+			const unsigned int w = camera.videoWidth(), h = camera.videoHeight();
+			const FrameFormat format = camera.frameFormat();
+			cv::Mat src;
+			if (format == FrameFormat::YUV420)
+			{
+				PiCameraStream::toBgr(cv::Mat(h * 3 / 2, w, CV_8UC1, const_cast<uint8_t*>(ref.data())), format, converted);
+				ref.release();
+				src = converted;
+			}
+			else
+				src = cv::Mat(h, w, format == FrameFormat::BGR ? CV_8UC3 : CV_8UC1, const_cast<uint8_t*>(ref.data()));
+
+			if (scale < 1.0f)
+			{
+				const int sw = std::max(2, (int)(w * scale) & ~1), sh = std::max(2, (int)(h * scale) & ~1);
+				cv::resize(src, scaled, cv::Size(sw, sh), 0, 0, cv::INTER_AREA);
+				ref.release();
+				src = scaled;
+			}
+
+			const bool ok = cv::imencode(".jpg", src, jpeg, { cv::IMWRITE_JPEG_QUALITY, quality });
+			ref.release();
+			if (!ok)
+				continue;
+
+			// bitrate estimate over the last ~10 frames
+			now = std::chrono::steady_clock::now();
+			const float dt = std::chrono::duration<float>(now - last_encoded).count();
+			last_encoded = now;
+			avg_bytes = avg_bytes == 0 ? (float)jpeg.size() : avg_bytes * 0.9f + (float)jpeg.size() * 0.1f;
+			if (!first)
+				avg_interval = avg_interval == 0 ? dt : avg_interval * 0.9f + dt * 0.1f;
+			first = false;
+			const float bitrate = avg_interval > 0 ? avg_bytes * 8 / avg_interval : 0;
+			if (++settle >= 10)
+				settle = adapt(bitrate) ? 0 : settle;
+
+			EncodedFrame frame = std::make_shared<const std::vector<uint8_t>>(std::move(jpeg));
+			jpeg = std::vector<uint8_t>();
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				latest = std::move(frame);
+				generation++;
+				counters.frames_encoded++;
+				counters.fps = avg_interval > 0 ? 1.0f / avg_interval : 0;
+				counters.bitrate = bitrate;
+				counters.quality = (uint8_t)quality;
+				counters.scale = scale;
+			}
+			cond.notify_all();
+		}
+	}
+
+	// one quality or resolution step towards the target, true if something changed
+	bool adapt(float bitrate)
+	{
+		if (options.target_bitrate == 0 || bitrate <= 0)
+			return false;
+
+		const int max_quality = options.quality, min_quality = std::min(options.min_quality, options.quality);
+		if (bitrate > options.target_bitrate * 1.1f)
+		{
+			const int step = bitrate > options.target_bitrate * 1.5f ? 10 : 5;
+			if (quality > min_quality)
+				quality = std::max(min_quality, quality - step);
+			else if (scale > 0.25f)
+			{
+				scale *= 0.5f;
+				quality = (min_quality + max_quality) / 2;
+			}
+			else
+				return false;
+			return true;
+		}
+
+		if (bitrate < options.target_bitrate * 0.7f)
+		{
+			if (quality < max_quality)
+				quality = std::min(max_quality, quality + 5);
+			else if (scale < 1.0f)
+			{
+				scale *= 2.0f;
+				quality = min_quality;
+			}
+			else
+				return false;
+			return true;
+		}
+		return false;
+	}
+
+	PiCameraStream& camera;
+	MjpegServerOptions options;
+	int listen_fd = -1;
+	std::atomic<bool> running{ false };
+	std::thread accept_thread;
+	std::thread encoder_thread;
+
+	// encoder state, encoder thread only
+	int quality = 80;
+	float scale = 1.0f;
+
+	mutable std::mutex mtx;
+	std::condition_variable cond;
+	std::list<Client> clients;
+	std::atomic<int> client_count{ 0 };
+	EncodedFrame latest;
+	uint64_t generation = 0;
+	MjpegServerStats counters;
+	std::atomic<uint64_t> bytes_sent{ 0 };
+};
@@ -0,0 +1,1934 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "BoundedQueue.h"
+#include "CameraReplay.h"
+#include "FrameRing.h"
+#include "ScaleKernels.h"
+#include "YuvKernels.h"
+#include "lccv.hpp"
+
+/**
+ * @file PiCameraStream.h
+ * @brief PiCamera with a lock-free frame ring for video capture.
+ *
+ * Drop-in replacement for PiCamera video mode. Instead of one framebuffer guarded by
+ * a mutex, captured frames are kept in a FrameRing (see FrameRing.h): the capture
+ * thread never waits for a reader, and a briefly slow consumer can still read every
+ * frame in order as long as it stays within the ring size.
+ *
+ * Design notes:
+ * - Photo mode and camera options are inherited from PiCamera unchanged;
+ *   startVideo(), getVideoFrame() and stopVideo() hide the PiCamera versions, so call
+ *   them on a PiCameraStream (not through a PiCamera pointer or reference)
+ * - Each frame is converted once, in the capture thread, from the camera buffer into
+ *   a ring slot; the buffer then goes straight back to libcamera, so no consumer can
+ *   stall the camera
+ * - Sequence numbers start at 1 and keep increasing across stopVideo()/startVideo();
+ *   the lores and ROI rings share them. Timestamps are the sensor timestamp
+ *   (CLOCK_MONOTONIC)
+ * - Optional features are described at their setters: setVideoFormat(),
+ *   setRequestQueue(), setLores(), addRoi(), subscribe(), setZsl(), setReplay(),
+ *   setStandby() and setSeedExposure(); capturePhoto() also works during video
+ *
+ * Threading notes:
+ * - startVideo(), stopVideo() and capturePhoto() are serialized and may be called
+ *   from different threads
+ * - getVideoFrame() keeps the last returned sequence number; use one consumer thread
+ *   per PiCameraStream for it, or nextFrame() with a cursor per consumer
+ * - latestFrame(), nextFrame(), frameAt() and frames() are safe from any thread
+ *   while the video is running
+ * - subscribe(), unsubscribe(), addListener() and removeListener() are safe from any
+ *   thread; FrameListener::onFrame() runs on a thread of its own per listener
+ *
+ * @ingroup doly_sdk_common
+ */
+
+/** @brief Default number of frames kept by PiCameraStream. */
+constexpr size_t PICAMERA_RING_SIZE = 4;
+
+/** @brief Longest wait for the still frame when capturePhoto() interrupts video. */
+constexpr unsigned int PICAMERA_PHOTO_TIMEOUT_MS = 3000;
+
+/** @brief Pixel format of PiCameraStream video and lores frames. */
+enum class FrameFormat : uint8_t
+{
+	BGR,	// CV_8UC3, height x width
+	GREY,	// CV_8UC1, height x width, the luma (Y) plane
+	YUV420,	// CV_8UC1, height * 3 / 2 x width, I420 plane order (COLOR_YUV2BGR_I420)
+};
+
+using LoresFormat = FrameFormat;
+
+/** @brief How a PiCameraStream ROI output fits its crop into the output size. */
+enum class RoiFit : uint8_t
+{
+	STRETCH,	// scale the crop to the output size, aspect ratio not kept
+	FILL,		// trim the crop to the output aspect ratio (centered), then scale
+	LETTERBOX,	// scale the whole crop into the output, pad with the border color
+};
+
+/** @brief Software crop and downscale of one PiCameraStream consumer (see PiCameraStream::addRoi()). */
+struct RoiOptions
+{
+	float x = 0, y = 0, width = 1, height = 1;	// crop, fractions of the video frame
+	unsigned int out_width = 0, out_height = 0;	// output size in pixels
+	RoiFit fit = RoiFit::FILL;
+	FrameFormat format = FrameFormat::BGR;
+	std::array<uint8_t, 3> border{};			// letterbox color (BGR)
+};
+
+/**
+ * @brief Capture metadata of one PiCameraStream video frame.
+ *
+ * Read from the request's ControlList once per frame and stored with the ring frame,
+ * copied without locks. The string-keyed CompletedRequest::post_process_metadata map
+ * is never used per frame (see tools/CameraMetaBench).
+ */
+struct VideoFrameInfo
+{
+	uint64_t seq = 0;					// PiCameraStream sequence number
+	uint32_t sensor_sequence = 0;		// sensor frame counter, gaps are frames the pipeline dropped
+	int64_t timestamp_ns = 0;			// sensor timestamp, start of exposure (CLOCK_MONOTONIC)
+	int64_t received_ns = 0;			// request completed in the capture thread
+	int64_t delivered_ns = 0;			// frame copied out to the consumer
+	float exposure_time = 0;			// microseconds
+	float analogue_gain = 0;
+	float digital_gain = 0;
+	std::array<float, 2> colour_gains{};	// red, blue
+	float focus = 0;					// focus figure of merit
+	float fps = 0;
+	bool aelock = false;
+
+	/** @brief Sensor timestamp to delivery to the consumer. */
+	int64_t latencyNs() const { return delivered_ns - timestamp_ns; }
+
+	/** @brief Sensor timestamp to the capture thread (camera pipeline only). */
+	int64_t pipelineLatencyNs() const { return received_ns - timestamp_ns; }
+
+	/**
+	 * @brief Fill the capture fields from a completed request's metadata.
+	 *
+	 * Missing controls read as 0, a missing SensorTimestamp as received_ns.
+	 *
+	 * @return True if exposure, analogue gain and colour gains were all present.
+	 */
+	bool readControls(const libcamera::ControlList& metadata)
+	{
+		auto sensor_ts = metadata.get(libcamera::controls::SensorTimestamp);
+		auto exposure = metadata.get(libcamera::controls::ExposureTime);
+		auto again = metadata.get(libcamera::controls::AnalogueGain);
+		auto dgain = metadata.get(libcamera::controls::DigitalGain);
+		auto gains = metadata.get(libcamera::controls::ColourGains);
+		auto fom = metadata.get(libcamera::controls::FocusFoM);
+		auto locked = metadata.get(libcamera::controls::AeLocked);
+		timestamp_ns = sensor_ts ? *sensor_ts : received_ns;
+		exposure_time = exposure ? (float)*exposure : 0.0f;
+		analogue_gain = again ? *again : 0.0f;
+		digital_gain = dgain ? *dgain : 0.0f;
+		colour_gains = gains ? std::array<float, 2>{ (*gains)[0], (*gains)[1] } : std::array<float, 2>{};
+		focus = fom ? (float)*fom : 0.0f;
+		aelock = locked ? *locked : false;
+		return exposure && again && gains;
+	}
+};
+
+// copied per frame as raw bytes next to the ring frame (FrameRing::Ref::meta())
+static_assert(std::is_trivially_copyable<VideoFrameInfo>::value, "VideoFrameInfo must stay plain data");
+
+/** @brief How PiCameraStream::startVideo() brought up the source. */
+enum class CameraStart : uint8_t
+{
+	COLD,		// camera opened and configured
+	WARM,		// camera kept acquired by standby (see PiCameraStream::setStandby())
+	REPLAY,		// replay backend
+};
+
+/** @brief Startup timing of the last PiCameraStream::startVideo(), from the call. */
+struct VideoStartInfo
+{
+	CameraStart mode = CameraStart::COLD;
+	bool reconfigured = false;		// viewfinder configured (always for COLD)
+	bool seeded = false;			// AE/AWB started from the last converged values
+	int64_t setup_ns = -1;			// camera started
+	int64_t first_frame_ns = -1;	// first frame in the ring, -1 = none yet
+	int64_t usable_ns = -1;			// first frame with AE locked (or fixed exposure), -1 = none yet
+};
+
+namespace picamera_detail
+{
+	// newest frame a consumer took; replay at framerate 0 waits for it, shared with
+	// the subscriptions, which may outlive the stream
+	struct DeliveryState
+	{
+		std::atomic<uint64_t> seq{ 0 };
+		std::mutex mtx;
+		std::condition_variable cond;
+
+		void mark(uint64_t taken)
+		{
+			uint64_t prev = seq.load();
+			while (prev < taken && !seq.compare_exchange_weak(prev, taken))
+			{
+			}
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+			}
+			cond.notify_all();
+		}
+	};
+}
+
+/** @brief Frame delivered to a subscriber: a pin on the ring frame and its metadata. */
+struct SubscribedFrame
+{
+	FrameRing::Ref frame;	// shared with the other subscribers, release when done
+	VideoFrameInfo info;
+};
+
+/**
+ * @brief Frame queue of one PiCameraStream subscriber (see PiCameraStream::subscribe()).
+ *
+ * Holds up to depth() frames; when full, the drop policy decides which frame this
+ * subscriber loses. BLOCK is not supported (it would stall every consumer) and acts
+ * like DROP_NEWEST.
+ */
+class FrameSubscription
+{
+public:
+	explicit FrameSubscription(size_t depth = 2, DropPolicy policy = DropPolicy::DROP_OLDEST)
+		: queue(depth, policy == DropPolicy::BLOCK ? DropPolicy::DROP_NEWEST : policy)
+	{
+	}
+
+	FrameSubscription(const FrameSubscription&) = delete;
+	FrameSubscription& operator=(const FrameSubscription&) = delete;
+
+	/**
+	 * @brief Take the oldest queued frame, waiting for one if necessary.
+	 *
+	 * @param timeout_ms Maximum wait, < 0 = until a frame arrives or unsubscribed.
+	 *
+	 * @return True on success; false on timeout, or if unsubscribed and drained.
+	 */
+	bool next(SubscribedFrame& frame, int timeout_ms = -1)
+	{
+		if (!queue.pop(frame, timeout_ms))
+			return false;
+		if (auto state = std::atomic_load(&delivery))
+			state->mark(frame.info.seq);
+		frame.info.delivered_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		return true;
+	}
+
+	size_t depth() const { return queue.capacity(); }
+	size_t queued() const { return queue.size(); }
+	size_t maxQueued() const { return queue.maxDepth(); }
+
+	/** @brief Frames queued for this subscriber since subscribe(). */
+	uint64_t received() const { return queue.pushed(); }
+
+	/** @brief Frames this subscriber lost to its full queue. */
+	uint64_t dropped() const { return queue.dropped(); }
+
+private:
+	friend class PiCameraStream;
+	BoundedQueue<SubscribedFrame> queue;
+	std::shared_ptr<picamera_detail::DeliveryState> delivery;	// set by subscribe()
+};
+
+/**
+ * @brief Callback interface for PiCameraStream::addListener().
+ */
+class FrameListener
+{
+public:
+	virtual ~FrameListener() = default;
+
+	/**
+	 * @brief Called for each frame on the listener's own thread; the pin is released
+	 *        when it returns (move frame.frame out to keep it).
+	 */
+	virtual void onFrame(SubscribedFrame& frame) = 0;
+};
+
+class PiCameraStream : public PiCamera
+{
+public:
+	PiCameraStream()
+		: replay_path(CameraReplay::envPath()), replay_fps(CameraReplay::envFramerate()), replay_loop(CameraReplay::envLoop())
+	{
+	}
+
+	~PiCameraStream()
+	{
+		stopVideo();
+		releaseCamera();
+		while (true)
+		{
+			FrameListener* listener;
+			{
+				std::lock_guard<std::mutex> lk(subscriber_mtx);
+				if (listeners.empty())
+					break;
+				listener = listeners.front()->listener;
+			}
+			removeListener(listener);
+		}
+
+		// queued pins must not outlive the ring
+		std::lock_guard<std::mutex> lk(subscriber_mtx);
+		for (FrameSubscription* subscription : subscribers)
+		{
+			subscription->queue.close();
+			subscription->queue.clear();
+		}
+	}
+
+	/**
+	 * @brief Serve frames from a recording instead of the camera (applied by the next start).
+	 *
+	 * Also enabled by DOLY_CAMERA_REPLAY (see CameraReplay.h). Frames go through the
+	 * same API and rings and are timestamped when delivered.
+	 *
+	 * @param path Video file, image directory or raw `.bgr` dump (see CameraReplay.h);
+	 *        empty to use the camera.
+	 * @param framerate Frames per second, 0 = as fast as consumers read (each frame waits
+	 *        until copied out or taken from a subscription), < 0 = options->framerate.
+	 * @param loop Restart at the end of the recording instead of stopping.
+	 */
+	void setReplay(const std::string& path, float framerate = -1.0f, bool loop = false)
+	{
+		replay_path = path;
+		replay_fps = framerate;
+		replay_loop = loop;
+	}
+
+	bool isReplay() const { return !replay_path.empty(); }
+
+	/**
+	 * @brief Set the number of frames kept in the ring (applied by the next startVideo()).
+	 *
+	 * @param count Number of frames, at least 1.
+	 */
+	void setRingSize(size_t count) { ring_size = count < 1 ? 1 : count; }
+
+	/**
+	 * @brief Set the completed request queue (applied by the next startVideo()).
+	 *
+	 * Completed requests pass through this queue from the thread waiting on libcamera
+	 * to the converting thread, so the library's queue is drained as fast as requests
+	 * complete; if conversion stalls, the policy drops requests and their buffers go
+	 * back to the camera. Every queued request holds a camera buffer, so keep @p depth
+	 * well below the pipeline's buffer count. BLOCK leaves requests in the library's
+	 * queue while the converter is busy, like capture without this queue.
+	 *
+	 * @param depth Maximum number of queued requests, at least 1 (default 2).
+	 * @param policy What happens to a request that arrives while the queue is full.
+	 */
+	void setRequestQueue(size_t depth, DropPolicy policy = DropPolicy::DROP_OLDEST)
+	{
+		request_depth = depth < 1 ? 1 : depth;
+		request_policy = policy;
+	}
+
+	/**
+	 * @brief Enable zero shutter lag mode (applied by the next startVideo()).
+	 *
+	 * Video is configured at options->photo_width x photo_height and the ring keeps
+	 * @p frames full-resolution frames (frames * width * height * 3 bytes for BGR,
+	 * see footprint()); capturePhoto(frame, timestamp) returns the one captured closest
+	 * to a trigger time without a new exposure, burst() consecutive ones. The ring
+	 * holds copies: holding the pipeline's few buffers would stall the camera. Use the
+	 * lores stream for preview and analysis in this mode; it keeps setRingSize()
+	 * frames.
+	 *
+	 * @param frames Number of frames to keep, 0 disables ZSL (back to setRingSize()).
+	 */
+	void setZsl(size_t frames) { zsl_frames = frames; }
+
+	/**
+	 * @brief Set the pixel format of the video frames (applied by the next startVideo()).
+	 *
+	 * Affects every frame read from the main ring: getVideoFrame(), nextFrame(),
+	 * latestFrame(), frameAt(), burst(), capturePhoto(frame, timestamp) and frames().
+	 * YUV420 frames have even dimensions (a BGR source is cropped by one pixel if needed).
+	 * A YUV420 camera stream is passed through plane by plane for YUV420 and GREY and
+	 * only converted for BGR (see YuvKernels.h); GREY consumers copy a third of the
+	 * BGR bytes.
+	 *
+	 * @param format BGR (default), GREY or YUV420.
+	 */
+	void setVideoFormat(FrameFormat format) { video_format = format; }
+
+	FrameFormat videoFormat() const { return video_format; }
+
+	/** @brief Format of the frames in frames() while video runs (set by startVideo()). */
+	FrameFormat frameFormat() const { return frame_format; }
+
+	/**
+	 * @brief Enable the lores stream (applied by the next startVideo()).
+	 *
+	 * A second ring filled from the same request with the same sequence numbers, so
+	 * analysis can run on the small frame and frameAt() fetches the matching full
+	 * frame only when needed. Frames come from the pipeline's lores stream (YUV420)
+	 * when one is configured, otherwise they are downscaled from the main frame.
+	 *
+	 * @param width Lores width, 0 disables the stream; rounded down to even.
+	 * @param height Lores height, 0 disables the stream; rounded down to even.
+	 * @param format Pixel format of the lores frames.
+	 */
+	void setLores(unsigned int width, unsigned int height, FrameFormat format = FrameFormat::YUV420)
+	{
+		lores_w = width & ~1u;
+		lores_h = height & ~1u;
+		lores_format = format;
+	}
+
+	/**
+	 * @brief Add a ROI output (applied by the next startVideo()).
+	 *
+	 * Every video frame is cropped to @p roi, area-downscaled to its output size and
+	 * stored in the output's ring (setRingSize() frames) in its format. Crops of a
+	 * YUV420 camera stream, and YUV420 outputs, use even coordinates; YUV420 output
+	 * sizes are rounded down to even. Computed in the capture thread straight from the
+	 * camera buffer (see ScaleKernels.h), without a full-size copy; unlike
+	 * Options::roi_* (sensor crop of every stream) it only affects this output. Call
+	 * while video is stopped and no consumer reads ROI frames.
+	 *
+	 * @param roi Crop, output size, fit and format.
+	 *
+	 * @return Output index (>= 0), or:
+	 * - -1 : video is running
+	 * - -2 : empty output size or crop
+	 */
+	int addRoi(const RoiOptions& roi)
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (streaming.load())
+			return -1;
+
+		RoiOptions o = roi;
+		if (o.format == FrameFormat::YUV420)
+		{
+			o.out_width &= ~1u;
+			o.out_height &= ~1u;
+		}
+		if (o.out_width == 0 || o.out_height == 0 || o.width <= 0 || o.height <= 0)
+			return -2;
+
+		rois.push_back(std::unique_ptr<RoiStage>(new RoiStage()));
+		rois.back()->options = o;
+		return (int)rois.size() - 1;
+	}
+
+	/**
+	 * @brief Remove every ROI output (while video is stopped and nobody reads them).
+	 */
+	void clearRois()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (!streaming.load())
+			rois.clear();
+	}
+
+	size_t roiCount() const { return rois.size(); }
+
+	/**
+	 * @brief Keep the camera acquired and configured between stopVideo() and startVideo().
+	 *
+	 * stopVideo() only stops the camera; its validated viewfinder configuration and
+	 * buffers are kept and reused while the camera index, video size, ZSL and rawfull
+	 * options are unchanged. The camera stays unavailable to other processes while in
+	 * standby. Photo mode (startPhoto(), capturePhoto() without video) releases it
+	 * first. Disabling standby while video is stopped releases the camera right away.
+	 *
+	 * @param enable True for warm standby, false to release the camera on stopVideo().
+	 */
+	void setStandby(bool enable)
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		standby = enable;
+		if (!enable && !streaming.load())
+			closeCamera();
+	}
+
+	bool isStandby() const { return standby; }
+
+	/**
+	 * @brief Release a camera kept by standby (no effect while video is running).
+	 */
+	void releaseCamera()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (!streaming.load())
+			closeCamera();
+	}
+
+	/**
+	 * @brief Start video from the last converged exposure and colour gains (default on).
+	 *
+	 * AE/AWB take over again after the first frame, starting from where they were
+	 * instead of reconverging. Values the options fix (shutter, gain, awb gains) are
+	 * left alone. Applied by the next startVideo(), if a previous run reported the
+	 * values.
+	 */
+	void setSeedExposure(bool enable) { seed_exposure = enable; }
+
+	/**
+	 * @brief Queue camera controls for the next request (or the next start).
+	 *
+	 * LibcameraApp::SetControls() replaces the controls pending in the library, and
+	 * exposure seeding sets controls too. Use this instead of app->SetControls() so
+	 * both are kept; a later call wins for the same control.
+	 *
+	 * @param controls Controls to add to the pending ones.
+	 */
+	void setControls(const libcamera::ControlList& controls) { mergeControls(controls); }
+
+	/**
+	 * @brief Startup timing of the last startVideo(); the frame times fill in as they arrive.
+	 *
+	 * See tools/CameraStartBench.
+	 */
+	VideoStartInfo lastStart()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		VideoStartInfo info = start_info;
+		info.first_frame_ns = first_frame_ns.load();
+		info.usable_ns = usable_ns.load();
+		return info;
+	}
+
+	/**
+	 * @brief Start video capture.
+	 *
+	 * @return True on success, false if video is already running.
+	 */
+	bool startVideo()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (camerastarted)
+			PiCamera::stopPhoto();
+		if (streaming.load())
+			return false;
+
+		start_call_ns = clockNs();
+		start_info = VideoStartInfo();
+		first_frame_ns.store(-1);
+		usable_ns.store(-1);
+
+		unsigned int w = 0, h = 0, stride = 0;
+		replay_active.store(!replay_path.empty());
+		source_yuv = false;
+		if (replay_active.load())
+		{
+			closeCamera();
+			if (replay.open(replay_path, options->video_width, options->video_height) != 0)
+				return false;
+			w = replay.width();
+			h = replay.height();
+			stride = w * 3;
+			start_info.mode = CameraStart::REPLAY;
+		}
+		else
+		{
+			if (camera_open && open_camera != options->camera)
+				closeCamera();
+			start_info.mode = camera_open ? CameraStart::WARM : CameraStart::COLD;
+			if (!camera_open)
+			{
+				app->OpenCamera();
+				camera_open = true;
+				open_camera = options->camera;
+			}
+			if (!vf_configured || !(vf_key == viewfinderKey()))
+			{
+				if (vf_configured)
+					app->Teardown();
+				configureViewfinder();
+				start_info.reconfigured = true;
+			}
+
+			libcamera::Stream* stream = app->ViewfinderStream(&w, &h, &stride);
+			if (stream == nullptr)
+			{
+				closeCamera();
+				return false;
+			}
+			source_yuv = stream->configuration().pixelFormat == libcamera::formats::YUV420;
+		}
+		if (video_format == FrameFormat::YUV420 && !source_yuv)
+		{
+			w &= ~1u;
+			h &= ~1u;
+		}
+
+		// consumers may still be copying from the ring: only touch the layout if it changes
+		if (w != vw || h != vh || video_format != frame_format)
+		{
+			vw = w;
+			vh = h;
+			frame_format = video_format;
+		}
+		vstr = stride;
+
+		zsl_active = zsl_frames != 0;
+		ring.configure((zsl_active ? zsl_frames : ring_size) + subscriberPins(), frameBytes(vw, vh, frame_format),
+			sizeof(VideoFrameInfo));
+		sensor_drops.store(0);
+		configureLores();
+		configureRois();
+		// a ring with a new layout restarts at 0, sequence numbers must not
+		seq_counter = std::max({ seq_counter, ring.latestSeq(), lores_ring.latestSeq() });
+		for (const auto& roi : rois)
+			seq_counter = std::max(seq_counter, roi->ring.latestSeq());
+		last_returned = seq_counter;
+		delivery->seq.store(seq_counter);
+		start_info.seeded = !replay_active.load() && seed_exposure && seedExposure();
+		seed_pending = start_info.seeded;
+		exposure_valid = false;
+		fixed_exposure = replay_active.load() || (options->shutter != 0 && options->gain != 0);
+		start_pending.store(true);
+		streaming.store(true);
+		if (replay_active.load())
+			capture_thread = std::thread([this] { replayLoop(); });
+		else
+			startCapture();
+		start_info.setup_ns = clockNs() - start_call_ns;
+		return true;
+	}
+
+	/**
+	 * @brief Stop video capture and release the camera (or keep it, see setStandby()).
+	 */
+	void stopVideo()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (!streaming.exchange(false))
+			return;
+
+		if (replay_active.load())
+		{
+			{
+				std::lock_guard<std::mutex> replay_lk(delivery->mtx);
+			}
+			delivery->cond.notify_all();
+			capture_thread.join();
+			replay.close();
+		}
+		else if (standby)
+			haltCapture();
+		else
+		{
+			stopCapture();
+			closeCamera();
+		}
+		ring.close();
+		lores_ring.close();
+		for (const auto& roi : rois)
+			roi->ring.close();
+	}
+
+	/**
+	 * @brief Photo mode; only marks the mode when replaying (see PiCamera::startPhoto()).
+	 */
+	bool startPhoto()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (isReplay())
+			return true;
+		closeCamera();
+		return PiCamera::startPhoto();
+	}
+
+	bool stopPhoto()
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		return isReplay() || PiCamera::stopPhoto();
+	}
+
+	/**
+	 * @brief Capture a still photo, also while video is running.
+	 *
+	 * Without video this is PiCamera::capturePhoto(), or the first recording frame when
+	 * replaying. In ZSL mode (setZsl()) and during replay it returns the newest ring
+	 * frame. Otherwise, during video, the stream is paused for the still and resumed
+	 * afterwards without releasing the camera. The still starts from the exposure and
+	 * gains of the last video frame, so AE/AWB do not reconverge. Video consumers see a
+	 * gap in frame times, not in sequence numbers. The video is resumed as well if no
+	 * still arrives within PICAMERA_PHOTO_TIMEOUT_MS.
+	 *
+	 * @param frame Output BGR photo (options->photo_width x photo_height).
+	 *
+	 * @return True on success, false on failure or timeout.
+	 */
+	bool capturePhoto(cv::Mat& frame)
+	{
+		std::lock_guard<std::mutex> lk(control_mtx);
+		if (!streaming.load() && isReplay())
+		{
+			bool ok = replay.open(replay_path, options->video_width, options->video_height) == 0 && replay.read(frame);
+			replay.close();
+			return ok;
+		}
+		if (!streaming.load())
+		{
+			closeCamera();
+			return PiCamera::capturePhoto(frame);
+		}
+		if ((zsl_active || replay_active.load()) && frame_format == FrameFormat::BGR)
+			return capturePhoto(frame, clockNs());
+		if (zsl_active || replay_active.load())
+		{
+			cv::Mat ring_frame;
+			if (!capturePhoto(ring_frame, clockNs()))
+				return false;
+			toBgr(ring_frame, frame_format, frame);
+			return true;
+		}
+
+		stopCapture();
+		const bool seeded = seedExposure();
+		app->ConfigureStill(still_flags);
+		startCamera();
+		const bool ok = waitStill(frame);
+
+		app->StopCamera();
+		app->Teardown();
+		configureViewfinder();
+		if (seeded)
+			restoreAuto();
+		startCapture();
+		return ok;
+	}
+
+	bool isStreaming() const { return streaming.load(); }
+
+	/**
+	 * @brief Zero shutter lag photo: the ring frame captured closest to @p timestamp_ns.
+	 *
+	 * No new exposure is made. If the trigger is newer than the newest frame, the next
+	 * frame is awaited (up to 200 ms) so the frame in exposure at trigger time counts.
+	 * Full resolution requires setZsl(), otherwise the frame has video resolution.
+	 * Safe to call from any thread while video is running.
+	 *
+	 * @param frame Output frame in the video format (setVideoFormat()).
+	 * @param timestamp_ns Trigger time (CLOCK_MONOTONIC, see clockNs()).
+	 * @param stamp Optional sequence number and timestamp of the returned frame.
+	 *
+	 * @return True on success, false if video is not running or the ring is empty.
+	 */
+	bool capturePhoto(cv::Mat& frame, int64_t timestamp_ns, FrameStamp* stamp = nullptr)
+	{
+		if (!streaming.load())
+			return false;
+
+		FrameRing::Ref latest = ring.acquireLatest();
+		if (!latest || latest.timestamp() < timestamp_ns)
+		{
+			const uint64_t after = latest ? latest.seq() : ring.latestSeq();
+			latest.release();
+			ring.wait(after, 200);
+		}
+		else
+			latest.release();
+
+		return copyOut(ring.acquireNearest(timestamp_ns), frame, stamp);
+	}
+
+	/**
+	 * @brief Burst of consecutive frames.
+	 *
+	 * Starts at the ring frame captured closest to @p timestamp_ns (0: the newest
+	 * frame) and continues with live frames until @p count frames are collected. Frames
+	 * are consecutive unless the caller falls more than the ring size behind.
+	 *
+	 * @param frames Output frames in the video format (resized to the number returned).
+	 * @param count Number of frames.
+	 * @param timestamp_ns Start time (CLOCK_MONOTONIC), 0 for the newest frame.
+	 * @param timeout Timeout per frame in milliseconds.
+	 * @param stamps Optional sequence numbers and timestamps of the frames.
+	 *
+	 * @return Number of frames collected.
+	 */
+	size_t burst(std::vector<cv::Mat>& frames, size_t count, int64_t timestamp_ns = 0,
+		unsigned int timeout = 1500, std::vector<FrameStamp>* stamps = nullptr)
+	{
+		frames.resize(count);
+		if (stamps != nullptr)
+			stamps->resize(count);
+
+		uint64_t after = 0;
+		size_t n = 0;
+		if (streaming.load() && count != 0)
+		{
+			FrameStamp stamp;
+			FrameRing::Ref start = timestamp_ns != 0 ? ring.acquireNearest(timestamp_ns) : ring.next(0, timeout);
+			if (copyOut(start, frames[0], &stamp))
+			{
+				start.release();
+				after = stamp.seq;
+				if (stamps != nullptr)
+					(*stamps)[0] = stamp;
+				for (n = 1; n < count && nextFrame(after, frames[n], timeout, &stamp); n++)
+				{
+					after = stamp.seq;
+					if (stamps != nullptr)
+						(*stamps)[n] = stamp;
+				}
+			}
+		}
+
+		frames.resize(n);
+		if (stamps != nullptr)
+			stamps->resize(n);
+		return n;
+	}
+
+	/**
+	 * @brief Current time on the frame timestamp clock (CLOCK_MONOTONIC), for triggers.
+	 */
+	static int64_t clockNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * @brief Convert a frame in @p format (as returned by this class, continuous) to BGR.
+	 */
+	static void toBgr(const cv::Mat& src, FrameFormat format, cv::Mat& bgr)
+	{
+		if (format == FrameFormat::BGR)
+		{
+			src.copyTo(bgr);
+			return;
+		}
+		if (format == FrameFormat::GREY)
+		{
+			cv::cvtColor(src, bgr, cv::COLOR_GRAY2BGR);
+			return;
+		}
+
+		const unsigned int w = (unsigned int)src.cols, h = (unsigned int)src.rows * 2 / 3;
+		const uint8_t* y = src.ptr();
+		bgr.create(h, w, CV_8UC3);
+		YuvKernels::i420ToBgr(y, w, y + w * h, y + w * h + w * h / 4, w / 2, bgr.ptr(), bgr.step[0], w, h);
+	}
+
+	/**
+	 * @brief Memory held by the frame rings (main, lores and ROI outputs) in bytes.
+	 */
+	size_t footprint() const
+	{
+		size_t bytes = ring.footprint() + (lores_on ? lores_ring.footprint() : 0);
+		for (const auto& roi : rois)
+			bytes += roi->on ? roi->ring.footprint() : 0;
+		return bytes;
+	}
+
+	/**
+	 * @brief Get the newest frame not returned by a previous call (PiCamera compatible).
+	 *
+	 * Frames that arrived in between are skipped; use nextFrame() to read every frame.
+	 *
+	 * @param frame Output frame in the video format (setVideoFormat()).
+	 * @param timeout Timeout in milliseconds.
+	 *
+	 * @return True on success, false on timeout or if video is not running.
+	 */
+	bool getVideoFrame(cv::Mat& frame, unsigned int timeout)
+	{
+		if (!streaming.load() || !ring.wait(last_returned, timeout))
+			return false;
+
+		FrameStamp stamp;
+		if (!copyOut(ring.acquireLatest(), frame, &stamp))
+			return false;
+		last_returned = stamp.seq;
+		return true;
+	}
+
+	/**
+	 * @brief getVideoFrame() with the frame's capture metadata.
+	 *
+	 * @param frame Output frame in the video format.
+	 * @param timeout Timeout in milliseconds.
+	 * @param info Output metadata; info.latencyNs() is the time from the sensor
+	 *        timestamp to this call returning the frame.
+	 *
+	 * @return True on success, false on timeout or if video is not running.
+	 */
+	bool getVideoFrame(cv::Mat& frame, unsigned int timeout, VideoFrameInfo& info)
+	{
+		if (!streaming.load() || !ring.wait(last_returned, timeout))
+			return false;
+
+		if (!copyOut(ring.acquireLatest(), frame, nullptr, &info))
+			return false;
+		last_returned = info.seq;
+		return true;
+	}
+
+	/**
+	 * @brief Copy the newest frame without waiting.
+	 *
+	 * @return True on success, false if no frame was captured yet.
+	 */
+	bool latestFrame(cv::Mat& frame, FrameStamp* stamp = nullptr)
+	{
+		return copyOut(ring.acquireLatest(), frame, stamp);
+	}
+
+	/**
+	 * @brief Wait for and copy the oldest frame newer than @p after.
+	 *
+	 * Pass the previous stamp->seq as @p after to read frames in order; a gap in the
+	 * sequence numbers means the consumer fell more than the ring size behind.
+	 *
+	 * @param after Last sequence number seen by this consumer (0 to start).
+	 * @param frame Output frame in the video format.
+	 * @param timeout Timeout in milliseconds.
+	 * @param stamp Optional sequence number and timestamp of the frame.
+	 *
+	 * @return True on success, false on timeout or if video stopped.
+	 */
+	bool nextFrame(uint64_t after, cv::Mat& frame, unsigned int timeout, FrameStamp* stamp = nullptr)
+	{
+		return copyOut(ring.next(after, timeout), frame, stamp);
+	}
+
+	/**
+	 * @brief nextFrame() with the frame's capture metadata (pass info.seq as @p after).
+	 */
+	bool nextFrame(uint64_t after, cv::Mat& frame, unsigned int timeout, VideoFrameInfo& info)
+	{
+		return copyOut(ring.next(after, timeout), frame, nullptr, &info);
+	}
+
+	/**
+	 * @brief Capture metadata of the frame with sequence number @p seq (also for lores
+	 *        frames, which share the sequence numbers).
+	 *
+	 * @return True on success, false if the frame is not (or no longer) in the ring.
+	 */
+	bool frameInfo(uint64_t seq, VideoFrameInfo& info) const
+	{
+		FrameRing::Ref ref = ring.acquire(seq);
+		if (!ref)
+			return false;
+		memcpy(&info, ref.meta(), sizeof(info));
+		return true;
+	}
+
+	/**
+	 * @brief Frames lost since startVideo(): gaps in the sensor frame counter, requests
+	 *        dropped from a full request queue and frames dropped because every ring
+	 *        slot was pinned.
+	 */
+	uint64_t droppedFrames() const
+	{
+		return sensor_drops.load(std::memory_order_relaxed) + request_queue.dropped() + ring.dropped();
+	}
+
+	/**
+	 * @brief Copy the frame with sequence number @p seq.
+	 *
+	 * @return True on success, false if the frame is not (or no longer) in the ring.
+	 */
+	bool frameAt(uint64_t seq, cv::Mat& frame, FrameStamp* stamp = nullptr)
+	{
+		return copyOut(ring.acquire(seq), frame, stamp);
+	}
+
+	/**
+	 * @brief Wait for and copy the oldest lores frame newer than @p after.
+	 *
+	 * @return True on success, false on timeout, if video stopped or lores is disabled.
+	 */
+	bool nextLoresFrame(uint64_t after, cv::Mat& frame, unsigned int timeout, FrameStamp* stamp = nullptr)
+	{
+		return lores_on && copyLores(lores_ring.next(after, timeout), frame, stamp);
+	}
+
+	/**
+	 * @brief Copy the newest lores frame without waiting.
+	 *
+	 * @return True on success, false if no frame was captured yet or lores is disabled.
+	 */
+	bool latestLoresFrame(cv::Mat& frame, FrameStamp* stamp = nullptr)
+	{
+		return lores_on && copyLores(lores_ring.acquireLatest(), frame, stamp);
+	}
+
+	/**
+	 * @brief Wait for and copy the oldest frame of ROI output @p index newer than @p after.
+	 *
+	 * @return True on success, false on timeout, if video stopped or the output is
+	 *         disabled (empty crop).
+	 */
+	bool nextRoiFrame(size_t index, uint64_t after, cv::Mat& frame, unsigned int timeout, FrameStamp* stamp = nullptr)
+	{
+		return index < rois.size() && rois[index]->on && copyRoi(*rois[index], rois[index]->ring.next(after, timeout), frame, stamp);
+	}
+
+	/**
+	 * @brief Copy the newest frame of ROI output @p index without waiting.
+	 *
+	 * @return True on success, false if no frame was captured yet or the output is disabled.
+	 */
+	bool latestRoiFrame(size_t index, cv::Mat& frame, FrameStamp* stamp = nullptr)
+	{
+		return index < rois.size() && rois[index]->on && copyRoi(*rois[index], rois[index]->ring.acquireLatest(), frame, stamp);
+	}
+
+	/**
+	 * @brief Where ROI output @p index comes from, to map results back to the video frame.
+	 *
+	 * Valid after startVideo().
+	 *
+	 * @param index Output index from addRoi().
+	 * @param crop Source rectangle in video frame pixels.
+	 * @param placed Where the crop lands in the output (smaller than the output when letterboxed).
+	 *
+	 * @return True on success, false for an unknown index.
+	 */
+	bool roiMapping(size_t index, cv::Rect& crop, cv::Rect& placed) const
+	{
+		if (index >= rois.size())
+			return false;
+		crop = rois[index]->crop;
+		placed = rois[index]->placed;
+		return true;
+	}
+
+	/**
+	 * @brief Deliver every new video frame to @p subscription until unsubscribe().
+	 *
+	 * Each frame arrives as a shared pin on the ring slot (FrameRing::Ref::share()),
+	 * not a copy, through the subscription's own queue and drop policy, so a slow
+	 * subscriber only loses its own frames. The slot is reused once the last pin is
+	 * released.
+	 *
+	 * Resets the subscription's queue and counters (do not call while its consumer is
+	 * in next()). The ring reserves depth() + 1 slots per subscriber from the next
+	 * startVideo() on; subscribe before startVideo() so the pins never starve the ring.
+	 * startVideo() drops frames still queued from the last run; release every
+	 * SubscribedFrame taken out before calling it.
+	 *
+	 * @warning The subscription must remain valid until removed via unsubscribe().
+	 */
+	void subscribe(FrameSubscription* subscription)
+	{
+		if (subscription == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lk(subscriber_mtx);
+		if (std::find(subscribers.begin(), subscribers.end(), subscription) != subscribers.end())
+			return;
+		subscription->queue.configure(subscription->queue.capacity(), subscription->queue.policy());
+		std::atomic_store(&subscription->delivery, delivery);
+		subscribers.push_back(subscription);
+		has_subscribers.store(true);
+	}
+
+	/**
+	 * @brief Stop delivering to @p subscription; its next() returns false once drained.
+	 *
+	 * Drain it and release its frames before the next startVideo().
+	 */
+	void unsubscribe(FrameSubscription* subscription)
+	{
+		{
+			std::lock_guard<std::mutex> lk(subscriber_mtx);
+			auto it = std::find(subscribers.begin(), subscribers.end(), subscription);
+			if (it == subscribers.end())
+				return;
+			subscribers.erase(it);
+			has_subscribers.store(!subscribers.empty());
+		}
+		subscription->queue.close();
+	}
+
+	/**
+	 * @brief Call @p listener for every new video frame, on a thread of its own.
+	 *
+	 * @param listener Listener object pointer.
+	 * @param depth Frames queued for the listener while it is busy.
+	 * @param policy Which frame the listener loses when its queue is full.
+	 *
+	 * @warning The listener must remain valid until removed via removeListener().
+	 */
+	void addListener(FrameListener* listener, size_t depth = 2, DropPolicy policy = DropPolicy::DROP_OLDEST)
+	{
+		if (listener == nullptr)
+			return;
+
+		auto entry = std::make_unique<ListenerEntry>(listener, depth, policy);
+		ListenerEntry* raw = entry.get();
+		{
+			std::lock_guard<std::mutex> lk(subscriber_mtx);
+			for (const auto& e : listeners)
+			{
+				if (e->listener == listener)
+					return;
+			}
+			listeners.push_back(std::move(entry));
+		}
+		subscribe(&raw->subscription);
+		raw->thread = std::thread([raw] {
+			SubscribedFrame frame;
+			while (raw->subscription.next(frame))
+			{
+				raw->listener->onFrame(frame);
+				frame = SubscribedFrame();
+			}
+		});
+	}
+
+	/**
+	 * @brief Unregister @p listener; onFrame() is not called after this returns.
+	 *
+	 * @warning Must not be called from the listener's own onFrame().
+	 */
+	void removeListener(FrameListener* listener)
+	{
+		std::unique_ptr<ListenerEntry> entry;
+		{
+			std::lock_guard<std::mutex> lk(subscriber_mtx);
+			for (auto it = listeners.begin(); it != listeners.end(); ++it)
+			{
+				if ((*it)->listener == listener)
+				{
+					entry = std::move(*it);
+					listeners.erase(it);
+					break;
+				}
+			}
+		}
+		if (!entry)
+			return;
+
+		unsubscribe(&entry->subscription);
+		entry->thread.join();
+	}
+
+	/**
+	 * @brief Frame ring for zero-copy access (FrameRing::Ref pins a frame in place).
+	 */
+	const FrameRing& frames() const { return ring; }
+
+	/**
+	 * @brief Lores frame ring, empty unless setLores() was called before startVideo().
+	 */
+	const FrameRing& loresFrames() const { return lores_ring; }
+
+	/**
+	 * @brief Ring of ROI output @p index (see addRoi()), for zero-copy access.
+	 */
+	const FrameRing& roiFrames(size_t index) const { return rois.at(index)->ring; }
+
+	/**
+	 * @brief Completed request queue, for its depth and drop counters.
+	 */
+	const BoundedQueue<CompletedRequestPtr>& requests() const { return request_queue; }
+
+	unsigned int videoWidth() const { return vw; }
+	unsigned int videoHeight() const { return vh; }
+	unsigned int loresWidth() const { return lores_on ? lores_w : 0; }
+	unsigned int loresHeight() const { return lores_on ? lores_h : 0; }
+
+protected:
+	// one ROI output (addRoi())
+	struct RoiStage
+	{
+		RoiOptions options;
+		FrameRing ring;
+		bool on = false;
+		cv::Rect crop;		// video frame pixels
+		cv::Rect placed;	// output pixels
+		ScaleKernels::AreaScaler scale[2];	// BGR or luma, chroma
+		std::vector<uint8_t> tmp;			// placed-size scratch when converting
+	};
+
+	// options the viewfinder configuration depends on; the rest are controls, applied
+	// by StartCamera()
+	struct ViewfinderKey
+	{
+		unsigned int width = 0, height = 0;
+		bool rawfull = false;
+
+		bool operator==(const ViewfinderKey& other) const
+		{
+			return width == other.width && height == other.height && rawfull == other.rawfull;
+		}
+	};
+
+	// ZSL runs the viewfinder at photo resolution
+	ViewfinderKey viewfinderKey() const
+	{
+		ViewfinderKey key;
+		key.width = zsl_frames == 0 ? options->video_width : options->photo_width;
+		key.height = zsl_frames == 0 ? options->video_height : options->photo_height;
+		key.rawfull = options->rawfull;
+		return key;
+	}
+
+	void configureViewfinder()
+	{
+		vf_key = viewfinderKey();
+		const unsigned int width = options->video_width, height = options->video_height;
+		options->video_width = vf_key.width;
+		options->video_height = vf_key.height;
+		app->ConfigureViewfinder();
+		options->video_width = width;
+		options->video_height = height;
+		vf_configured = true;
+	}
+
+	// release a camera kept by standby or left by a failed start
+	void closeCamera()
+	{
+		if (vf_configured)
+			app->Teardown();
+		if (camera_open)
+			app->CloseCamera();
+		vf_configured = false;
+		camera_open = false;
+	}
+
+	static size_t frameBytes(unsigned int w, unsigned int h, FrameFormat format)
+	{
+		const size_t pixels = (size_t)w * h;
+		return format == FrameFormat::BGR ? pixels * 3 : format == FrameFormat::GREY ? pixels : pixels * 3 / 2;
+	}
+
+	static cv::Mat frameMat(uint8_t* data, unsigned int w, unsigned int h, FrameFormat format)
+	{
+		if (format == FrameFormat::BGR)
+			return cv::Mat(h, w, CV_8UC3, data);
+		if (format == FrameFormat::GREY)
+			return cv::Mat(h, w, CV_8UC1, data);
+		return cv::Mat(h * 3 / 2, w, CV_8UC1, data);
+	}
+
+	// planes of a mapped YUV420 buffer, chroma stride is half the luma stride
+	static void yuvPlanes(const std::vector<libcamera::Span<uint8_t>>& mem, unsigned int stride, unsigned int h,
+		const uint8_t* planes[3])
+	{
+		planes[0] = mem[0].data();
+		if (mem.size() >= 3)
+		{
+			planes[1] = mem[1].data();
+			planes[2] = mem[2].data();
+			return;
+		}
+		planes[1] = planes[0] + (size_t)stride * h;
+		planes[2] = planes[1] + (size_t)(stride / 2) * (h / 2);
+	}
+
+	// one w x h frame, packed BGR (src[0]) or YUV420 planes, into a ring slot in @p format
+	static void convertFrame(const uint8_t* const src[3], size_t stride, bool yuv, unsigned int w, unsigned int h,
+		FrameFormat format, uint8_t* dst)
+	{
+		uint8_t* u = dst + (size_t)w * h;
+		uint8_t* v = u + (size_t)w * h / 4;
+		if (yuv)
+		{
+			if (format == FrameFormat::BGR)
+			{
+				YuvKernels::i420ToBgr(src[0], stride, src[1], src[2], stride / 2, dst, (size_t)w * 3, w, h);
+				return;
+			}
+
+			YuvKernels::copyPlane(src[0], stride, dst, w, w, h);
+			if (format == FrameFormat::YUV420)
+			{
+				YuvKernels::copyPlane(src[1], stride / 2, u, w / 2, w / 2, h / 2);
+				YuvKernels::copyPlane(src[2], stride / 2, v, w / 2, w / 2, h / 2);
+			}
+			return;
+		}
+
+		if (format == FrameFormat::BGR)
+			YuvKernels::copyPlane(src[0], stride, dst, (size_t)w * 3, (size_t)w * 3, h);
+		else if (format == FrameFormat::GREY)
+			YuvKernels::bgrToGrey(src[0], stride, dst, w, w, h);
+		else
+			YuvKernels::bgrToI420(src[0], stride, dst, w, u, v, w / 2, w, h);
+	}
+
+	void configureLores()
+	{
+		lores_on = lores_w != 0 && lores_h != 0;
+		lores_stream = nullptr;
+		if (!lores_on)
+			return;
+
+		// use the pipeline's lores stream if the configuration has a matching one
+		unsigned int w = 0, h = 0, stride = 0;
+		libcamera::Stream* stream = replay_active.load() ? nullptr : app->LoresStream(&w, &h, &stride);
+		if (stream != nullptr && w == lores_w && h == lores_h)
+		{
+			lores_stream = stream;
+			lores_stride = stride;
+		}
+
+		lores_tmp.resize(source_yuv && lores_stream == nullptr ? frameBytes(lores_w, lores_h, FrameFormat::YUV420) : 0);
+		lores_ring.configure(ring_size, frameBytes(lores_w, lores_h, lores_format));
+	}
+
+	// pipeline lores stream (YUV420)
+	void writeLoresFromStream(const CompletedRequestPtr& payload, uint8_t* dst)
+	{
+		const uint8_t* planes[3];
+		yuvPlanes(app->Mmap(payload->buffers[lores_stream]), lores_stride, lores_h, planes);
+		convertFrame(planes, lores_stride, true, lores_w, lores_h, lores_format, dst);
+	}
+
+	// no lores stream: downscale the main frame, straight from the camera buffer
+	void writeLoresFromMain(const uint8_t* const src[3], size_t stride, bool yuv, uint8_t* dst)
+	{
+		const cv::Size size(lores_w, lores_h);
+		if (!yuv)
+		{
+			cv::Mat main(vh, vw, CV_8UC3, const_cast<uint8_t*>(src[0]), stride);
+			if (lores_format == FrameFormat::BGR)
+			{
+				cv::Mat out = frameMat(dst, lores_w, lores_h, lores_format);
+				cv::resize(main, out, size, 0, 0, cv::INTER_AREA);
+				return;
+			}
+
+			cv::resize(main, lores_scaled, size, 0, 0, cv::INTER_AREA);
+			const uint8_t* scaled[3] = { lores_scaled.ptr(), nullptr, nullptr };
+			convertFrame(scaled, lores_scaled.step[0], false, lores_w, lores_h, lores_format, dst);
+			return;
+		}
+
+		// YUV420: scale plane by plane, into the slot unless BGR is wanted
+		uint8_t* y = lores_format == FrameFormat::BGR ? lores_tmp.data() : dst;
+		cv::Mat y_out(size, CV_8UC1, y);
+		cv::resize(cv::Mat(vh, vw, CV_8UC1, const_cast<uint8_t*>(src[0]), stride), y_out, size, 0, 0, cv::INTER_AREA);
+		if (lores_format == FrameFormat::GREY)
+			return;
+
+		const cv::Size half(lores_w / 2, lores_h / 2);
+		uint8_t* u = y + (size_t)lores_w * lores_h;
+		uint8_t* v = u + (size_t)lores_w * lores_h / 4;
+		cv::Mat u_out(half, CV_8UC1, u), v_out(half, CV_8UC1, v);
+		cv::resize(cv::Mat(vh / 2, vw / 2, CV_8UC1, const_cast<uint8_t*>(src[1]), stride / 2), u_out, half, 0, 0, cv::INTER_AREA);
+		cv::resize(cv::Mat(vh / 2, vw / 2, CV_8UC1, const_cast<uint8_t*>(src[2]), stride / 2), v_out, half, 0, 0, cv::INTER_AREA);
+		if (lores_format == FrameFormat::BGR)
+		{
+			const uint8_t* planes[3] = { y, u, v };
+			convertFrame(planes, lores_w, true, lores_w, lores_h, lores_format, dst);
+		}
+	}
+
+	// crop and placement of each ROI output for the current video size and source
+	void configureRois()
+	{
+		for (const auto& stage : rois)
+		{
+			RoiStage& roi = *stage;
+			const RoiOptions& o = roi.options;
+			// chroma planes need even crops and, in the output, even placement
+			const unsigned int align = source_yuv || o.format == FrameFormat::YUV420 ? ~1u : ~0u;
+			const unsigned int place_align = o.format == FrameFormat::YUV420 ? ~1u : ~0u;
+
+			// crop in video pixels
+			const float x0 = std::min(std::max(o.x, 0.0f), 1.0f), y0 = std::min(std::max(o.y, 0.0f), 1.0f);
+			const float x1 = std::min(o.x + o.width, 1.0f), y1 = std::min(o.y + o.height, 1.0f);
+			int cx = (int)std::lround(x0 * vw), cy = (int)std::lround(y0 * vh);
+			int cw = std::max((int)std::lround(x1 * vw) - cx, 0), ch = std::max((int)std::lround(y1 * vh) - cy, 0);
+			const int64_t ow = o.out_width, oh = o.out_height;
+			if (o.fit == RoiFit::FILL && cw > 0 && ch > 0)
+			{
+				if (cw * oh > ch * ow)
+				{
+					const int w = (int)(ch * ow / oh);
+					cx += (cw - w) / 2;
+					cw = w;
+				}
+				else
+				{
+					const int h = (int)(cw * oh / ow);
+					cy += (ch - h) / 2;
+					ch = h;
+				}
+			}
+			roi.crop = cv::Rect(cx & align, cy & align, cw & align, ch & align);
+
+			// placement in the output
+			roi.placed = cv::Rect(0, 0, (int)ow, (int)oh);
+			if (o.fit == RoiFit::LETTERBOX && cw > 0 && ch > 0)
+			{
+				int pw = (int)ow, ph = (int)oh;
+				if (cw * oh > ch * ow)
+					ph = (int)std::max<int64_t>((ow * ch + cw / 2) / cw, 1);
+				else
+					pw = (int)std::max<int64_t>((oh * cw + ch / 2) / ch, 1);
+				roi.placed = cv::Rect(((int)ow - pw) / 2, ((int)oh - ph) / 2, pw, ph);
+			}
+			roi.placed = cv::Rect(roi.placed.x & place_align, roi.placed.y & place_align, roi.placed.width & place_align,
+				roi.placed.height & place_align);
+
+			roi.on = roi.crop.area() > 0 && roi.placed.area() > 0;
+			if (!roi.on)
+				continue;
+
+			// YUV420 sources are scaled plane by plane, odd sizes round the chroma up
+			const cv::Rect& c = roi.crop;
+			const cv::Rect& p = roi.placed;
+			const size_t channels = source_yuv ? 1 : 3;
+			const size_t uv_w = (p.width + 1) / 2, uv_h = (p.height + 1) / 2;
+			roi.scale[0].configure(c.width, c.height, p.width, p.height, channels);
+			if (source_yuv)
+				roi.scale[1].configure(c.width / 2, c.height / 2, uv_w, uv_h, 1);
+
+			size_t tmp = 0;
+			if (source_yuv && o.format == FrameFormat::BGR)
+				tmp = (size_t)p.width * p.height + uv_w * uv_h * 2;
+			else if (!source_yuv && o.format != FrameFormat::BGR)
+				tmp = (size_t)p.width * p.height * 3;
+			roi.tmp.resize(tmp);
+			roi.ring.configure(ring_size, frameBytes(o.out_width, o.out_height, o.format));
+		}
+	}
+
+	// crop, scale and convert straight from the source frame into the output slot
+	void writeRoi(RoiStage& roi, const uint8_t* const src[3], size_t stride, uint8_t* dst)
+	{
+		const RoiOptions& o = roi.options;
+		const cv::Rect& c = roi.crop;
+		const cv::Rect& p = roi.placed;
+		const size_t ow = o.out_width, oh = o.out_height;
+		const size_t uv_offset = ow / 2 * (p.y / 2) + p.x / 2;	// placed rect in the chroma planes
+		if (p.width != (int)ow || p.height != (int)oh)
+			fillBorder(roi, dst);
+
+		if (!source_yuv)
+		{
+			const uint8_t* in = src[0] + stride * c.y + (size_t)c.x * 3;
+			if (o.format == FrameFormat::BGR)
+			{
+				roi.scale[0].run(in, stride, dst + (ow * p.y + p.x) * 3, ow * 3);
+				return;
+			}
+
+			const size_t tmp_stride = (size_t)p.width * 3;
+			roi.scale[0].run(in, stride, roi.tmp.data(), tmp_stride);
+			if (o.format == FrameFormat::GREY)
+				YuvKernels::bgrToGrey(roi.tmp.data(), tmp_stride, dst + ow * p.y + p.x, ow, p.width, p.height);
+			else
+				YuvKernels::bgrToI420(roi.tmp.data(), tmp_stride, dst + ow * p.y + p.x, ow,
+					dst + ow * oh + uv_offset, dst + ow * oh * 5 / 4 + uv_offset, ow / 2, p.width, p.height);
+			return;
+		}
+
+		// YUV420 source: luma, then both chroma planes at half size
+		const size_t uv_stride = stride / 2;
+		const uint8_t* in_y = src[0] + stride * c.y + c.x;
+		const uint8_t* in_u = src[1] + uv_stride * (c.y / 2) + c.x / 2;
+		const uint8_t* in_v = src[2] + uv_stride * (c.y / 2) + c.x / 2;
+		if (o.format != FrameFormat::BGR)
+		{
+			roi.scale[0].run(in_y, stride, dst + ow * p.y + p.x, ow);
+			if (o.format == FrameFormat::GREY)
+				return;
+			roi.scale[1].run(in_u, uv_stride, dst + ow * oh + uv_offset, ow / 2);
+			roi.scale[1].run(in_v, uv_stride, dst + ow * oh * 5 / 4 + uv_offset, ow / 2);
+			return;
+		}
+
+		const size_t pw = p.width, ph = p.height, cw = (pw + 1) / 2;
+		uint8_t* ty = roi.tmp.data();
+		uint8_t* tu = ty + pw * ph;
+		uint8_t* tv = tu + cw * ((ph + 1) / 2);
+		roi.scale[0].run(in_y, stride, ty, pw);
+		roi.scale[1].run(in_u, uv_stride, tu, cw);
+		roi.scale[1].run(in_v, uv_stride, tv, cw);
+		YuvKernels::i420ToBgr(ty, pw, tu, tv, cw, dst + (ow * p.y + p.x) * 3, ow * 3, pw, ph);
+	}
+
+	// letterbox bars around roi.placed
+	static void fillBorder(const RoiStage& roi, uint8_t* dst)
+	{
+		const RoiOptions& o = roi.options;
+		const cv::Rect& p = roi.placed;
+		const unsigned int ow = o.out_width, oh = o.out_height;
+		const uint8_t* bgr = o.border.data();
+		if (o.format == FrameFormat::BGR)
+		{
+			fillOutside(dst, (size_t)ow * 3, ow, oh, p, bgr, 3);
+			return;
+		}
+
+		uint8_t y;
+		YuvKernels::bgrToGreyRowScalar(bgr, &y, 1);
+		fillOutside(dst, ow, ow, oh, p, &y, 1);
+		if (o.format == FrameFormat::GREY)
+			return;
+
+		const uint8_t block[6] = { bgr[0], bgr[1], bgr[2], bgr[0], bgr[1], bgr[2] };
+		uint8_t u, v;
+		YuvKernels::bgrToUvRowScalar(block, block, &u, &v, 2);
+		const cv::Rect half(p.x / 2, p.y / 2, p.width / 2, p.height / 2);
+		uint8_t* u_plane = dst + (size_t)ow * oh;
+		fillOutside(u_plane, ow / 2, ow / 2, oh / 2, half, &u, 1);
+		fillOutside(u_plane + (size_t)ow * oh / 4, ow / 2, ow / 2, oh / 2, half, &v, 1);
+	}
+
+	// fill a w x h plane outside of @p inner with the pixel @p px (bpp bytes)
+	static void fillOutside(uint8_t* plane, size_t stride, unsigned int w, unsigned int h, const cv::Rect& inner,
+		const uint8_t* px, size_t bpp)
+	{
+		for (unsigned int r = 0; r < h; r++)
+		{
+			uint8_t* row = plane + stride * r;
+			const bool bar = (int)r < inner.y || (int)r >= inner.y + inner.height;
+			const unsigned int left = bar ? w : inner.x;
+			const unsigned int right = bar ? w : inner.x + inner.width;
+			for (unsigned int x = 0; x < left; x++)
+				memcpy(row + x * bpp, px, bpp);
+			for (unsigned int x = right; x < w; x++)
+				memcpy(row + x * bpp, px, bpp);
+		}
+	}
+
+	// viewfinder must be configured; camera stays acquired
+	void startCapture()
+	{
+		last_sensor_sequence = 0;
+		sensor_sequence_valid = false;
+		request_queue.configure(request_depth, request_policy);
+		startCamera();
+		process_thread = std::thread([this] { processLoop(); });
+		capture_thread = std::thread([this] { captureLoop(); });
+	}
+
+	// first still frame, or false after PICAMERA_PHOTO_TIMEOUT_MS: app->Wait() has no
+	// timeout, so a watchdog posts a Quit to wake it (StopCamera() drops a late one)
+	bool waitStill(cv::Mat& frame)
+	{
+		std::mutex mtx;
+		std::condition_variable cond;
+		bool done = false;
+		std::atomic<bool> expired{ false };
+		std::thread watchdog([&] {
+			std::unique_lock<std::mutex> lk(mtx);
+			if (cond.wait_for(lk, std::chrono::milliseconds(PICAMERA_PHOTO_TIMEOUT_MS), [&] { return done; }))
+				return;
+			expired.store(true);
+			LibcameraApp::MsgType quit = LibcameraApp::MsgType::Quit;
+			LibcameraApp::MsgPayload none;
+			app->PostMessage(quit, none);
+		});
+
+		bool ok = false;
+		while (true)
+		{
+			LibcameraApp::Msg msg = app->Wait();
+			// a Quit left over from the stopped video is not ours
+			if (msg.type == LibcameraApp::MsgType::Quit && !expired.load())
+				continue;
+
+			ok = msg.type == LibcameraApp::MsgType::RequestComplete;
+			if (ok)
+				getImage(frame, std::get<CompletedRequestPtr>(msg.payload));
+			break;
+		}
+
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			done = true;
+		}
+		cond.notify_one();
+		watchdog.join();
+		return ok;
+	}
+
+	void stopCapture()
+	{
+		haltCapture();
+		app->Teardown();
+		vf_configured = false;
+	}
+
+	// camera stays configured, StartCamera() resumes it
+	void haltCapture()
+	{
+		LibcameraApp::MsgType quit = LibcameraApp::MsgType::Quit;
+		LibcameraApp::MsgPayload none;
+		app->PostMessage(quit, none);
+		capture_thread.join();
+		process_thread.join();
+
+		app->StopCamera();
+	}
+
+	// start the next StartCamera() from the converged video exposure, unless the options
+	// fix it; returns false if there is nothing to seed from
+	bool seedExposure()
+	{
+		if (!exposure_valid)
+			return false;
+
+		libcamera::ControlList controls;
+		if (options->shutter == 0)
+			controls.set(libcamera::controls::ExposureTime, last_exposure_us);
+		if (options->gain == 0)
+			controls.set(libcamera::controls::AnalogueGain, last_analogue_gain);
+		if (options->awb_gain_r == 0 && options->awb_gain_b == 0)
+			controls.set(libcamera::controls::ColourGains, libcamera::Span<const float, 2>(last_colour_gains));
+		mergeControls(controls);
+		return true;
+	}
+
+	// hand exposure and AWB back to the algorithms after seedExposure()
+	void restoreAuto()
+	{
+		libcamera::ControlList controls;
+		if (options->shutter == 0)
+			controls.set(libcamera::controls::ExposureTime, 0);
+		if (options->gain == 0)
+			controls.set(libcamera::controls::AnalogueGain, 0.0f);
+		if (options->awb_gain_r == 0 && options->awb_gain_b == 0)
+		{
+			controls.set(libcamera::controls::ColourGains, libcamera::Span<const float, 2>({ 0.0f, 0.0f }));
+			controls.set(libcamera::controls::AwbEnable, true);
+		}
+		mergeControls(controls);
+	}
+
+	// app->SetControls() replaces the library's pending list: add @p controls to ours
+	// and hand over the merged list, so controls set through setControls() survive
+	void mergeControls(const libcamera::ControlList& controls)
+	{
+		std::lock_guard<std::mutex> lk(pending_mtx);
+		for (const auto& control : controls)
+			pending_controls.set(control.first, control.second);
+		libcamera::ControlList merged = pending_controls;
+		app->SetControls(merged);
+	}
+
+	// StartCamera() applies and clears the library's pending list, ours follows
+	void startCamera()
+	{
+		app->StartCamera();
+		std::lock_guard<std::mutex> lk(pending_mtx);
+		pending_controls.clear();
+	}
+
+	// only moves completed requests into request_queue, never waits on a consumer
+	void captureLoop()
+	{
+		while (true)
+		{
+			LibcameraApp::Msg msg = app->Wait();
+			if (msg.type == LibcameraApp::MsgType::Quit)
+				break;
+			if (msg.type == LibcameraApp::MsgType::RequestComplete)
+				request_queue.push(std::move(std::get<CompletedRequestPtr>(msg.payload)));
+		}
+		request_queue.close();
+	}
+
+	void processLoop()
+	{
+		libcamera::Stream* stream = app->ViewfinderStream();
+		CompletedRequestPtr payload;
+		while (request_queue.pop(payload))
+		{
+			VideoFrameInfo info;
+			info.received_ns = clockNs();
+			info.seq = ++seq_counter;
+			info.fps = payload->framerate;
+			if (info.readControls(payload->metadata))
+			{
+				last_exposure_us = (int32_t)info.exposure_time;
+				last_analogue_gain = info.analogue_gain;
+				last_colour_gains = info.colour_gains;
+				exposure_valid = true;
+			}
+
+			libcamera::FrameBuffer* buffer = payload->buffers[stream];
+			info.sensor_sequence = buffer->metadata().sequence;
+			if (sensor_sequence_valid && info.sensor_sequence > last_sensor_sequence + 1)
+				sensor_drops.fetch_add(info.sensor_sequence - last_sensor_sequence - 1, std::memory_order_relaxed);
+			last_sensor_sequence = info.sensor_sequence;
+			sensor_sequence_valid = true;
+
+			auto mem = app->Mmap(buffer);
+			const uint8_t* planes[3] = { mem[0].data(), nullptr, nullptr };
+			if (source_yuv)
+				yuvPlanes(mem, vstr, vh, planes);
+			publishFrame(planes, vstr, info, &payload);
+			payload.reset();
+
+			// the seeded first frame is out, AE/AWB carry on from it
+			if (seed_pending)
+			{
+				seed_pending = false;
+				restoreAuto();
+			}
+		}
+	}
+
+	void replayLoop()
+	{
+		const float fps = replay_fps < 0 ? options->framerate : replay_fps;
+		const std::chrono::nanoseconds interval(fps > 0 ? (int64_t)(1e9 / fps) : 0);
+		auto due = std::chrono::steady_clock::now();
+		cv::Mat frame;
+		while (streaming.load())
+		{
+			if (!replay.read(frame))
+			{
+				replay.rewind();
+				if (!replay_loop || !replay.read(frame))
+					break;
+			}
+
+			if (interval.count() > 0)
+			{
+				std::unique_lock<std::mutex> lk(delivery->mtx);
+				if (delivery->cond.wait_until(lk, due, [this] { return !streaming.load(); }))
+					break;
+				due = std::max(due + interval, std::chrono::steady_clock::now() - interval);
+			}
+
+			VideoFrameInfo info;
+			info.seq = ++seq_counter;
+			info.sensor_sequence = (uint32_t)info.seq;
+			info.timestamp_ns = info.received_ns = clockNs();
+			info.fps = fps;
+			const uint64_t seq = info.seq;
+			const uint8_t* planes[3] = { frame.ptr(), nullptr, nullptr };
+			publishFrame(planes, frame.step[0], info, nullptr);
+
+			// as fast as possible: hand over frame by frame
+			if (interval.count() == 0)
+			{
+				std::unique_lock<std::mutex> lk(delivery->mtx);
+				delivery->cond.wait(lk, [&] { return delivery->seq.load() >= seq || !streaming.load(); });
+			}
+		}
+
+		// end of the recording
+		ring.close();
+		lores_ring.close();
+		for (const auto& roi : rois)
+			roi->ring.close();
+	}
+
+	// main: packed BGR in main[0], or YUV420 planes if the camera stream is YUV420
+	void publishFrame(const uint8_t* const main[3], size_t stride, const VideoFrameInfo& info,
+		const CompletedRequestPtr* payload)
+	{
+		const uint64_t seq = info.seq;
+		const int64_t timestamp = info.timestamp_ns;
+		uint8_t* meta = nullptr;
+		uint8_t* dst = ring.beginWrite(&meta);
+		if (dst != nullptr)
+		{
+			convertFrame(main, stride, source_yuv, vw, vh, frame_format, dst);
+			memcpy(meta, &info, sizeof(info));
+			ring.commit(seq, timestamp);
+		}
+
+		// lores last: once a lores frame is visible, frameAt() finds its main frame
+		uint8_t* lores = lores_on ? lores_ring.beginWrite() : nullptr;
+		if (lores != nullptr)
+		{
+			if (lores_stream != nullptr && payload != nullptr)
+				writeLoresFromStream(*payload, lores);
+			else
+				writeLoresFromMain(main, stride, source_yuv, lores);
+			lores_ring.commit(seq, timestamp);
+		}
+
+		for (const auto& roi : rois)
+		{
+			uint8_t* out = roi->on ? roi->ring.beginWrite() : nullptr;
+			if (out == nullptr)
+				continue;
+			writeRoi(*roi, main, stride, out);
+			roi->ring.commit(seq, timestamp);
+		}
+
+		if (dst != nullptr && has_subscribers.load())
+			fanOut(seq, info);
+		if (dst != nullptr && start_pending.load(std::memory_order_relaxed))
+			noteStart(info);
+	}
+
+	// lastStart() frame times, until the first usable frame
+	void noteStart(const VideoFrameInfo& info)
+	{
+		const int64_t elapsed = info.received_ns - start_call_ns;
+		if (first_frame_ns.load() < 0)
+			first_frame_ns.store(elapsed);
+		if (info.aelock || fixed_exposure)
+		{
+			usable_ns.store(elapsed);
+			start_pending.store(false);
+		}
+	}
+
+	// one pin per subscriber on the frame just published
+	void fanOut(uint64_t seq, const VideoFrameInfo& info)
+	{
+		FrameRing::Ref ref = ring.acquire(seq);
+		if (!ref)
+			return;
+
+		std::lock_guard<std::mutex> lk(subscriber_mtx);
+		for (FrameSubscription* subscription : subscribers)
+			subscription->queue.push({ ref.share(), info });
+	}
+
+	// ring slots the subscribers may pin: a full queue plus the frame being processed;
+	// frames still queued from the last run are dropped, the ring may be reallocated
+	size_t subscriberPins()
+	{
+		std::lock_guard<std::mutex> lk(subscriber_mtx);
+		size_t pins = 0;
+		for (FrameSubscription* subscription : subscribers)
+		{
+			subscription->queue.clear();
+			pins += subscription->depth() + 1;
+		}
+		return pins;
+	}
+
+	bool copyOut(const FrameRing::Ref& ref, cv::Mat& frame, FrameStamp* stamp, VideoFrameInfo* info = nullptr)
+	{
+		if (!copyFrame(ref, vw, vh, frame_format, frame, stamp))
+			return false;
+
+		// still pinned: the slot's metadata belongs to this frame
+		if (info != nullptr)
+		{
+			memcpy(info, ref.meta(), sizeof(*info));
+			info->delivered_ns = clockNs();
+		}
+		return true;
+	}
+
+	bool copyLores(const FrameRing::Ref& ref, cv::Mat& frame, FrameStamp* stamp)
+	{
+		return copyFrame(ref, lores_w, lores_h, lores_format, frame, stamp);
+	}
+
+	bool copyRoi(const RoiStage& roi, const FrameRing::Ref& ref, cv::Mat& frame, FrameStamp* stamp)
+	{
+		return copyFrame(ref, roi.options.out_width, roi.options.out_height, roi.options.format, frame, stamp);
+	}
+
+	bool copyFrame(const FrameRing::Ref& ref, unsigned int w, unsigned int h, FrameFormat format, cv::Mat& frame,
+		FrameStamp* stamp)
+	{
+		if (!ref)
+			return false;
+
+		frameMat(const_cast<uint8_t*>(ref.data()), w, h, format).copyTo(frame);
+		if (stamp != nullptr)
+			*stamp = ref.stamp();
+		if (replay_active.load())
+			delivery->mark(ref.seq());
+		return true;
+	}
+
+	FrameRing ring;
+	size_t ring_size = PICAMERA_RING_SIZE;
+	size_t zsl_frames = 0;
+	bool zsl_active = false;
+	std::thread capture_thread;
+	std::thread process_thread;
+	std::atomic<bool> streaming{ false };
+	std::mutex control_mtx;
+	uint64_t seq_counter = 0;
+	uint64_t last_returned = 0;
+	FrameFormat video_format = FrameFormat::BGR;
+	FrameFormat frame_format = FrameFormat::BGR; // format of the ring, set by startVideo()
+	bool source_yuv = false;
+
+	// per ring slot, guarded by the slot state like the pixels
+
+	struct ListenerEntry
+	{
+		ListenerEntry(FrameListener* l, size_t depth, DropPolicy policy) : listener(l), subscription(depth, policy) {}
+		FrameListener* listener;
+		FrameSubscription subscription;
+		std::thread thread;
+	};
+
+	std::mutex subscriber_mtx;
+	std::vector<FrameSubscription*> subscribers;
+	std::vector<std::unique_ptr<ListenerEntry>> listeners;
+	std::atomic<bool> has_subscribers{ false };
+	std::atomic<uint64_t> sensor_drops{ 0 };
+	uint32_t last_sensor_sequence = 0;
+	BoundedQueue<CompletedRequestPtr> request_queue{ 2 };
+	size_t request_depth = 2;
+	DropPolicy request_policy = DropPolicy::DROP_OLDEST;
+	bool sensor_sequence_valid = false;
+
+	FrameRing lores_ring;
+	unsigned int lores_w = 0, lores_h = 0, lores_stride = 0;
+	FrameFormat lores_format = FrameFormat::YUV420;
+	bool lores_on = false;
+	libcamera::Stream* lores_stream = nullptr;
+	std::vector<uint8_t> lores_tmp;
+	cv::Mat lores_scaled;
+
+	std::vector<std::unique_ptr<RoiStage>> rois;	// only changes while video is stopped
+
+	// last video exposure, written by the capture thread, read while it is stopped
+	bool exposure_valid = false;
+	int32_t last_exposure_us = 0;
+	float last_analogue_gain = 0;
+	std::array<float, 2> last_colour_gains{};
+	bool seed_exposure = true;
+	bool seed_pending = false;	// capture thread: restoreAuto() after the first frame
+
+	// controls handed to app->SetControls() since the last StartCamera()
+	std::mutex pending_mtx;
+	libcamera::ControlList pending_controls;
+
+	// warm standby, guarded by control_mtx
+	bool standby = false;
+	bool camera_open = false;
+	unsigned int open_camera = 0;
+	bool vf_configured = false;
+	ViewfinderKey vf_key;
+
+	// startup timing: start_info under control_mtx, frame times from the capture thread
+	VideoStartInfo start_info;
+	int64_t start_call_ns = 0;
+	bool fixed_exposure = false;
+	std::atomic<bool> start_pending{ false };
+	std::atomic<int64_t> first_frame_ns{ -1 };
+	std::atomic<int64_t> usable_ns{ -1 };
+
+	CameraReplay replay;
+	std::string replay_path;
+	float replay_fps = -1.0f;
+	bool replay_loop = false;
+	std::atomic<bool> replay_active{ false };
+	std::shared_ptr<picamera_detail::DeliveryState> delivery = std::make_shared<picamera_detail::DeliveryState>();
+};
@@ -0,0 +1,287 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCALE_NEON 1
+#else
+#define SCALE_NEON 0
+#endif
+
+/**
+ * @file ScaleKernels.h
+ * @brief Area (box-filter) resampling of 8-bit planes, used by PiCameraStream ROI outputs.
+ *
+ * AreaScaler resamples a source rectangle (for example a crop of the mapped camera
+ * buffer, addressed by pointer and stride) straight into the destination, one output
+ * row at a time: a vertical pass blends the source rows covering the output row into
+ * a 16-bit (8.8 fixed point) row buffer of the source width, a horizontal pass reduces
+ * it to the output width. Only that one row buffer is allocated, at configure() time.
+ *
+ * Design notes:
+ * - Each output pixel is the average of the source area it covers, weighted by the
+ *   overlap (like cv::INTER_AREA when downscaling); upscaling degrades to
+ *   nearest-neighbour with blended edges. Results may differ from OpenCV by 1
+ * - Weights are Q15 per axis (each axis sums to exactly 32768); sums stay within 32
+ *   bits at any ratio
+ * - 1 (plane) or 3 (packed BGR) interleaved channels
+ * - NEON (Raspberry Pi) runs the vertical pass 16 bytes per iteration and the
+ *   horizontal pass of 2:1 reductions 8 pixels per iteration; other horizontal
+ *   ratios, the tail and non-ARM builds use the scalar path; both produce identical
+ *   bytes. The vertical pass touches every source byte, the horizontal pass only the
+ *   output rows
+ * - Same size on both axes is a plain row copy
+ *
+ * @ingroup doly_sdk_common
+ */
+
+namespace ScaleKernels
+{
+	/** @brief Source taps of each output pixel along one axis. */
+	struct AreaTaps
+	{
+		std::vector<uint32_t> first;	// first source index per output
+		std::vector<uint16_t> weights;	// count weights per output, Q15, zero padded
+		uint32_t count = 0;				// taps per output
+		bool halves = false;			// exact 2:1, weights 16384 16384
+	};
+
+	/**
+	 * @brief Overlap weights of @p dst outputs covering @p src inputs.
+	 */
+	inline void areaTaps(size_t src, size_t dst, AreaTaps& taps)
+	{
+		// in units of 1 / (src * dst): output i covers [i * src, (i + 1) * src),
+		// input j covers [j * dst, (j + 1) * dst)
+		uint32_t count = 1;
+		for (size_t i = 0; i < dst; i++)
+		{
+			const size_t lo = i * src / dst, hi = ((i + 1) * src + dst - 1) / dst;
+			count = std::max<uint32_t>(count, (uint32_t)(hi - lo));
+		}
+
+		taps.count = count;
+		taps.halves = src == dst * 2;
+		taps.first.assign(dst, 0);
+		taps.weights.assign(dst * count, 0);
+		for (size_t i = 0; i < dst; i++)
+		{
+			const size_t start = i * src, end = (i + 1) * src;
+			const size_t lo = start / dst;
+			const size_t base = std::min(lo, src - count);
+			taps.first[i] = (uint32_t)base;
+
+			// cumulative rounding keeps the sum at exactly 32768
+			size_t covered = 0;
+			uint32_t assigned = 0;
+			for (size_t j = lo; j * dst < end; j++)
+			{
+				covered += std::min(end, (j + 1) * dst) - std::max(start, j * dst);
+				const uint32_t cum = (uint32_t)(((uint64_t)covered * 32768 + src / 2) / src);
+				taps.weights[i * count + (j - base)] = (uint16_t)(cum - assigned);
+				assigned = cum;
+			}
+		}
+	}
+
+	/**
+	 * @brief Portable reference implementation of blendRows().
+	 */
+	inline void blendRowsScalar(const uint8_t* const* rows, const uint16_t* weights, uint32_t count,
+		uint16_t* acc, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			uint32_t sum = 0;
+			for (uint32_t k = 0; k < count; k++)
+				sum += (uint32_t)weights[k] * rows[k][i];
+			acc[i] = (uint16_t)((sum + 64) >> 7);
+		}
+	}
+
+	/**
+	 * @brief Portable reference implementation of reduceRow().
+	 */
+	template <size_t CH>
+	inline void reduceRowScalar(const uint16_t* acc, const AreaTaps& taps, uint8_t* dst, size_t begin, size_t end)
+	{
+		for (size_t x = begin; x < end; x++)
+		{
+			const uint16_t* src = acc + (size_t)taps.first[x] * CH;
+			const uint16_t* w = &taps.weights[x * taps.count];
+			for (size_t c = 0; c < CH; c++)
+			{
+				uint32_t sum = 0;
+				for (uint32_t k = 0; k < taps.count; k++)
+					sum += (uint32_t)w[k] * src[k * CH + c];
+				dst[x * CH + c] = (uint8_t)((sum + (1u << 22)) >> 23);
+			}
+		}
+	}
+
+#if SCALE_NEON
+	inline size_t blendRowsNeon(const uint8_t* const* rows, const uint16_t* weights, uint32_t count,
+		uint16_t* acc, size_t bytes)
+	{
+		size_t i = 0;
+		for (; i + 16 <= bytes; i += 16)
+		{
+			uint32x4_t sum[4] = { vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0) };
+			for (uint32_t k = 0; k < count; k++)
+			{
+				if (weights[k] == 0)
+					continue;
+				const uint8x16_t p = vld1q_u8(rows[k] + i);
+				const uint16x8_t lo = vmovl_u8(vget_low_u8(p)), hi = vmovl_u8(vget_high_u8(p));
+				sum[0] = vmlal_n_u16(sum[0], vget_low_u16(lo), weights[k]);
+				sum[1] = vmlal_n_u16(sum[1], vget_high_u16(lo), weights[k]);
+				sum[2] = vmlal_n_u16(sum[2], vget_low_u16(hi), weights[k]);
+				sum[3] = vmlal_n_u16(sum[3], vget_high_u16(hi), weights[k]);
+			}
+			vst1q_u16(acc + i, vcombine_u16(vrshrn_n_u32(sum[0], 7), vrshrn_n_u32(sum[1], 7)));
+			vst1q_u16(acc + i + 8, vcombine_u16(vrshrn_n_u32(sum[2], 7), vrshrn_n_u32(sum[3], 7)));
+		}
+		return i;
+	}
+
+	// 2:1, weights 16384 + 16384: round(16384 * (a + b) / 2^23) = round((a + b) / 2^9)
+	inline size_t halveRowNeon1(const uint16_t* acc, uint8_t* dst, size_t count)
+	{
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			const uint32x4_t lo = vpaddlq_u16(vld1q_u16(acc + x * 2));
+			const uint32x4_t hi = vpaddlq_u16(vld1q_u16(acc + x * 2 + 8));
+			vst1_u8(dst + x, vmovn_u16(vcombine_u16(vrshrn_n_u32(lo, 9), vrshrn_n_u32(hi, 9))));
+		}
+		return x;
+	}
+
+	inline size_t halveRowNeon3(const uint16_t* acc, uint8_t* dst, size_t count)
+	{
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			const uint16x8x3_t p0 = vld3q_u16(acc + x * 6);
+			const uint16x8x3_t p1 = vld3q_u16(acc + x * 6 + 24);
+			uint8x8x3_t out;
+			for (int c = 0; c < 3; c++)
+				out.val[c] = vmovn_u16(vcombine_u16(vrshrn_n_u32(vpaddlq_u16(p0.val[c]), 9),
+					vrshrn_n_u32(vpaddlq_u16(p1.val[c]), 9)));
+			vst3_u8(dst + x * 3, out);
+		}
+		return x;
+	}
+#endif
+
+	/**
+	 * @brief Weighted sum of @p count source rows into an 8.8 fixed point row (vertical pass).
+	 *
+	 * @param rows Source rows (bytes each).
+	 * @param weights Q15 weight per row, summing to at most 32768.
+	 * @param count Number of rows.
+	 * @param acc Output row, @p bytes values.
+	 * @param bytes Row length in bytes (width * channels).
+	 */
+	inline void blendRows(const uint8_t* const* rows, const uint16_t* weights, uint32_t count, uint16_t* acc, size_t bytes)
+	{
+		size_t done = 0;
+#if SCALE_NEON
+		done = blendRowsNeon(rows, weights, count, acc, bytes);
+#endif
+		blendRowsScalar(rows, weights, count, acc, done, bytes);
+	}
+
+	/**
+	 * @brief Reduce a blended row to the output width (horizontal pass).
+	 *
+	 * @param acc Row from blendRows().
+	 * @param taps Horizontal taps (see areaTaps()).
+	 * @param dst Output row (taps.first.size() * CH bytes).
+	 */
+	template <size_t CH>
+	inline void reduceRow(const uint16_t* acc, const AreaTaps& taps, uint8_t* dst)
+	{
+		const size_t count = taps.first.size();
+		size_t done = 0;
+#if SCALE_NEON
+		if (taps.halves)
+			done = CH == 1 ? halveRowNeon1(acc, dst, count) : halveRowNeon3(acc, dst, count);
+#endif
+		reduceRowScalar<CH>(acc, taps, dst, done, count);
+	}
+
+	/**
+	 * @brief Area resampling of a fixed source size to a fixed output size.
+	 *
+	 * configure() once, then run() per frame with any source and output pointers.
+	 */
+	class AreaScaler
+	{
+	public:
+		/**
+		 * @param src_w Source width in pixels.
+		 * @param src_h Source height in pixels.
+		 * @param dst_w Output width in pixels.
+		 * @param dst_h Output height in pixels.
+		 * @param channels 1 or 3 interleaved 8-bit channels.
+		 */
+		void configure(size_t src_w, size_t src_h, size_t dst_w, size_t dst_h, size_t channels)
+		{
+			sw = src_w;
+			sh = src_h;
+			dw = dst_w;
+			dh = dst_h;
+			ch = channels == 3 ? 3 : 1;
+			copy = sw == dw && sh == dh;
+			if (copy || sw == 0 || sh == 0 || dw == 0 || dh == 0)
+				return;
+
+			areaTaps(sw, dw, x_taps);
+			areaTaps(sh, dh, y_taps);
+			acc.resize(sw * ch);
+			rows.resize(y_taps.count);
+		}
+
+		/**
+		 * @param src Top left source pixel.
+		 * @param src_stride Source row pitch in bytes.
+		 * @param dst Top left output pixel.
+		 * @param dst_stride Output row pitch in bytes.
+		 */
+		void run(const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride)
+		{
+			if (copy)
+			{
+				for (size_t r = 0; r < dh; r++)
+					memcpy(dst + dst_stride * r, src + src_stride * r, dw * ch);
+				return;
+			}
+			if (dw == 0 || dh == 0 || sw == 0 || sh == 0)
+				return;
+
+			const uint32_t count = y_taps.count;
+			for (size_t r = 0; r < dh; r++)
+			{
+				const uint32_t first = y_taps.first[r];
+				for (uint32_t k = 0; k < count; k++)
+					rows[k] = src + src_stride * (first + k);
+				blendRows(rows.data(), &y_taps.weights[r * count], count, acc.data(), sw * ch);
+				if (ch == 3)
+					reduceRow<3>(acc.data(), x_taps, dst + dst_stride * r);
+				else
+					reduceRow<1>(acc.data(), x_taps, dst + dst_stride * r);
+			}
+		}
+
+	private:
+		size_t sw = 0, sh = 0, dw = 0, dh = 0, ch = 1;
+		bool copy = false;
+		AreaTaps x_taps, y_taps;
+		std::vector<uint16_t> acc;
+		std::vector<const uint8_t*> rows;
+	};
+};
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <string>
 #include <stdint.h>
+#include <future>
 #include <vector>
 
 /**
@@ -18,12 +19,58 @@
  * Design notes:
  * - Frames are stored as raw byte buffers
  * - All frames in a sequence must have identical dimensions
+ * - Pre-converted content can be memory-mapped from a `.vcb` container (see VContentMap.h)
+ * - getImageInto() / loadAsync() also load QOI and raw PAM/PPM images (see VContentFormats.h)
+ * - map(), getImageInto() and loadAsync() are defined in VContentMap.h, VContentFormats.h
+ *   and VContentLoader.h; include the header of the call you use
  *
  * @defgroup doly_common_vcontent VContent
  * @brief Common visual content container for Doly.
  * @{
  */
 
+ /**
+  * @brief Read-only view of one frame buffer.
+  *
+  * Points into memory owned by someone else (a VContent frame, a mapped `.vcb` file, ...).
+  * The view is only valid while its owner is alive and unchanged.
+  */
+struct VFrameView
+{
+	/** @brief First byte of the frame, nullptr if the view is empty. */
+	const uint8_t* data = nullptr;
+
+	/** @brief Frame size in bytes. */
+	size_t size = 0;
+
+	bool empty() const { return size == 0; }
+	const uint8_t* begin() const { return data; }
+	const uint8_t* end() const { return data + size; }
+	const uint8_t& operator[](size_t i) const { return data[i]; }
+};
+
+class VContentMap;
+
+/**
+ * @brief Load options for VContent::loadAsync() and VContent::getImageInto().
+ */
+struct VContentLoadOptions
+{
+	/** @brief True if the image contains an alpha channel. */
+	bool isRGBA = false;
+
+	/** @brief If true, convert image to 12-bit color depth. */
+	bool set12Bit = false;
+
+	/**
+	 * @brief If true, multiply the color channels by alpha (RGBA only).
+	 *
+	 * Premultiplied frames composite with one multiply-add per channel. Quantization
+	 * (set12Bit) is applied after premultiplying.
+	 */
+	bool premultiply = false;
+};
+
  /**
   * @brief Container class for visual (image/animation) content.
   */
@@ -33,6 +80,21 @@ public:
 	VContent() = default;
 	~VContent() = default;
 
+	/**
+	 * @brief Copying duplicates every frame buffer; prefer moving.
+	 */
+	VContent(const VContent&) = default;
+	VContent& operator=(const VContent&) = default;
+
+	/**
+	 * @brief Moving transfers the frame buffers without copying.
+	 *
+	 * Declared explicitly: the user-declared destructor would otherwise suppress the
+	 * implicit move operations and turn every return/assignment into a deep copy.
+	 */
+	VContent(VContent&&) noexcept = default;
+	VContent& operator=(VContent&&) noexcept = default;
+
 	/**
 	 * @brief Check whether the visual content is loaded and ready.
 	 * @return true if content was loaded successfully; false otherwise.
@@ -49,6 +111,22 @@ public:
 	 */
 	std::vector<std::vector<uint8_t>> frames;
 
+	/**
+	 * @brief Read-only view of one frame buffer.
+	 *
+	 * For contiguous, aligned storage of a whole sequence see VFrameStore.h.
+	 *
+	 * @param index Frame index.
+	 *
+	 * @return View of frames[index]; empty if @p index is out of range.
+	 */
+	VFrameView frameView(uint16_t index) const
+	{
+		if (index >= frames.size())
+			return {};
+		return { frames[index].data(), frames[index].size() };
+	}
+
 	/** @brief Selected frame index on load. */
 	uint16_t active_frame_id = 0;
 
@@ -106,9 +184,77 @@ public:
 	 */
 	static VContent getImage(std::string path, bool isRGBA, bool set12Bit);
 
+	/**
+	 * @brief Memory-map a `.vcb` container without decoding or copying.
+	 *
+	 * The container stores the header fields and raw frames already in the final byte
+	 * layout (see VContentMap.h), so opening it costs one open()+mmap() regardless of
+	 * the number of frames. Use VContentMap::frame() to access frames as views.
+	 *
+	 * @param path Path to the `.vcb` file.
+	 *
+	 * @return Mapped content; check VContentMap::isReady() for success.
+	 *
+	 * @note Defined in VContentMap.h.
+	 */
+	static VContentMap map(const std::string& path);
+
+	/**
+	 * @brief Load an image on the shared loader thread pool (see VContentLoader.h).
+	 *
+	 * @param path Path to the image file (PNG, QOI, PAM/PPM or `.vcb`, see VContentFormats.h).
+	 * @param options Load options.
+	 *
+	 * @return Future for the loaded content; check isReady() on the result.
+	 *
+	 * @note Defined in VContentLoader.h.
+	 */
+	static std::future<VContent> loadAsync(const std::string& path, const VContentLoadOptions& options = {});
+
+	/**
+	 * @brief Load an image into an existing VContent.
+	 *
+	 * The format is chosen by file signature (see VContentFormats.h). For `.vcb`, QOI,
+	 * PAM/PPM and RGB/RGBA PNG files the pixels are written into @p target's existing frame
+	 * buffers, so reloading same-sized content does not allocate. Other PNGs (palette, gray,
+	 * interlaced, animated) are decoded by getImage() and its frame buffers are moved into
+	 * @p target without copying.
+	 *
+	 * @param target Content to load into; left not ready on failure.
+	 * @param path Path to the image file (PNG, QOI, PAM/PPM or `.vcb`).
+	 * @param isRGBA True if the image contains an alpha channel.
+	 * @param set12Bit If true, convert image to 12-bit color depth.
+	 *
+	 * @return true if content was loaded successfully; false otherwise.
+	 *
+	 * @note Defined in VContentFormats.h.
+	 */
+	static bool getImageInto(VContent& target, const std::string& path, bool isRGBA, bool set12Bit);
+
+	/**
+	 * @brief Load an image into an existing VContent with extended options.
+	 *
+	 * Same as getImageInto(VContent&, const std::string&, bool, bool), with optional
+	 * alpha premultiplication (see VContentLoadOptions::premultiply).
+	 */
+	static bool getImageInto(VContent& target, const std::string& path, const VContentLoadOptions& options);
+
 private:
+	friend struct VContentAccess;
+
 	/** @brief Internal loaded flag. */
 	bool loaded = false;
 };
 
+/**
+ * @brief Internal accessor used by the header-only VContent loaders.
+ *
+ * Lets SDK helpers that build a VContent outside of getImage() (e.g. from a `.vcb` file)
+ * mark it as loaded. Not intended for application code.
+ */
+struct VContentAccess
+{
+	static void setLoaded(VContent& content, bool loaded) { content.loaded = loaded; }
+};
+
 /** @} */ // end of group doly_common_vcontent
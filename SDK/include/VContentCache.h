@@ -0,0 +1,231 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include "VContent.h"
+#include "VContentFormats.h"
+
+/**
+ * @file VContentCache.h
+ * @brief Process-wide, reference-counted VContent asset cache.
+ *
+ * VContent::getImage() returns an independent deep copy of all frames on every call.
+ * The cache loads each (path, isRGBA, set12Bit) combination once and hands out
+ * shared, read-only handles to the same frames.
+ *
+ * Design notes:
+ * - Singleton-style cache (namespace API; no instances)
+ * - Concurrent get() calls for the same key share a single load
+ * - Optional LRU eviction under a byte budget; evicting only drops the cache's
+ *   reference, handles already returned stay valid
+ * - `.vcb` files (see VContentMap.h) are loaded without decoding, see VContent::getImageInto()
+ *
+ * Threading notes:
+ * - All functions are thread-safe
+ * - Loads run on the calling thread, without holding the cache lock
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+namespace VContentCache
+{
+	struct Entry
+	{
+		std::shared_future<std::shared_ptr<const VContent>> content;
+		std::list<std::tuple<std::string, bool, bool>>::iterator lru;
+		size_t bytes = 0;
+	};
+
+	struct State
+	{
+		std::mutex mtx;
+		std::map<std::tuple<std::string, bool, bool>, Entry> entries;
+		// most recently used first
+		std::list<std::tuple<std::string, bool, bool>> lru;
+		size_t bytes = 0;
+		size_t budget = 0;
+	};
+
+	inline State& state()
+	{
+		static State instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Total frame bytes held by a content.
+	 */
+	inline size_t contentBytes(const VContent& content)
+	{
+		size_t bytes = 0;
+		for (const auto& frame : content.frames)
+			bytes += frame.capacity();
+		return bytes;
+	}
+
+	/**
+	 * @brief Drop least recently used, fully loaded entries until the budget is met.
+	 * @warning Caller must hold State::mtx.
+	 */
+	inline void evictLocked(State& s)
+	{
+		if (s.budget == 0)
+			return;
+
+		auto it = s.lru.end();
+		while (s.bytes > s.budget && it != s.lru.begin())
+		{
+			--it;
+			auto entry = s.entries.find(*it);
+			// entries still loading have no size yet, skip them
+			if (entry->second.bytes == 0)
+				continue;
+
+			s.bytes -= entry->second.bytes;
+			s.entries.erase(entry);
+			it = s.lru.erase(it);
+		}
+	}
+
+	/**
+	 * @brief Get shared content, loading it on first use.
+	 *
+	 * @param path Path to the image file (PNG, QOI, PAM/PPM or `.vcb`, see VContentFormats.h).
+	 * @param isRGBA True if the image contains an alpha channel.
+	 * @param set12Bit If true, convert image to 12-bit color depth.
+	 *
+	 * @return Shared read-only content, or nullptr if loading failed (an exception
+	 * thrown while loading, e.g. std::bad_alloc, counts as a failure).
+	 */
+	inline std::shared_ptr<const VContent> get(const std::string& path, bool isRGBA, bool set12Bit)
+	{
+		State& s = state();
+		auto key = std::make_tuple(path, isRGBA, set12Bit);
+		std::promise<std::shared_ptr<const VContent>> loader;
+		std::shared_future<std::shared_ptr<const VContent>> pending;
+
+		{
+			std::lock_guard<std::mutex> lk(s.mtx);
+			auto it = s.entries.find(key);
+			if (it != s.entries.end())
+			{
+				s.lru.splice(s.lru.begin(), s.lru, it->second.lru);
+				pending = it->second.content;
+			}
+			else
+			{
+				s.lru.push_front(key);
+				Entry& entry = s.entries[key];
+				entry.content = loader.get_future().share();
+				entry.lru = s.lru.begin();
+			}
+		}
+
+		// cached or being loaded by another thread
+		if (pending.valid())
+			return pending.get();
+
+		// every path below must fulfil the promise, or callers waiting on it break
+		std::shared_ptr<VContent> content;
+		try
+		{
+			content = std::make_shared<VContent>();
+			if (!VContent::getImageInto(*content, path, isRGBA, set12Bit))
+				content.reset();
+		}
+		catch (...)
+		{
+			content.reset();
+		}
+
+		{
+			std::lock_guard<std::mutex> lk(s.mtx);
+			auto it = s.entries.find(key);
+			if (content == nullptr)
+			{
+				// do not cache failures, the next get() retries
+				if (it != s.entries.end())
+				{
+					s.lru.erase(it->second.lru);
+					s.entries.erase(it);
+				}
+			}
+			else if (it != s.entries.end())
+			{
+				it->second.bytes = contentBytes(*content);
+				s.bytes += it->second.bytes;
+				evictLocked(s);
+			}
+		}
+
+		loader.set_value(content);
+		return content;
+	}
+
+	/**
+	 * @brief Set the LRU byte budget.
+	 *
+	 * @param bytes Maximum frame bytes kept by the cache (0 = unlimited, default).
+	 */
+	inline void setByteBudget(size_t bytes)
+	{
+		State& s = state();
+		std::lock_guard<std::mutex> lk(s.mtx);
+		s.budget = bytes;
+		evictLocked(s);
+	}
+
+	/**
+	 * @brief Get frame bytes currently held by the cache.
+	 */
+	inline size_t getBytes()
+	{
+		State& s = state();
+		std::lock_guard<std::mutex> lk(s.mtx);
+		return s.bytes;
+	}
+
+	/**
+	 * @brief Remove one entry from the cache.
+	 *
+	 * @return true if the entry existed and was fully loaded.
+	 */
+	inline bool remove(const std::string& path, bool isRGBA, bool set12Bit)
+	{
+		State& s = state();
+		std::lock_guard<std::mutex> lk(s.mtx);
+		auto it = s.entries.find(std::make_tuple(path, isRGBA, set12Bit));
+		if (it == s.entries.end() || it->second.bytes == 0)
+			return false;
+
+		s.bytes -= it->second.bytes;
+		s.lru.erase(it->second.lru);
+		s.entries.erase(it);
+		return true;
+	}
+
+	/**
+	 * @brief Remove all fully loaded entries. Loads in progress are kept.
+	 */
+	inline void clear()
+	{
+		State& s = state();
+		std::lock_guard<std::mutex> lk(s.mtx);
+		for (auto it = s.entries.begin(); it != s.entries.end();)
+		{
+			if (it->second.bytes == 0)
+			{
+				++it;
+				continue;
+			}
+			s.bytes -= it->second.bytes;
+			s.lru.erase(it->second.lru);
+			it = s.entries.erase(it);
+		}
+	}
+};
@@ -0,0 +1,777 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "QoiCodec.h"
+#include "VPixelKernels.h"
+#include "VContent.h"
+#include "VContentMap.h"
+
+/**
+ * @file VContentFormats.h
+ * @brief Fast-decoding image formats for VContent (PNG rows, QOI and raw PAM/PPM).
+ *
+ * PNG decode (inflate + row filters) dominates load time for the 240x240 eye assets.
+ * RGB/RGBA PNGs are decoded row by row straight into the pixel kernels (see loadPng()).
+ * Besides PNG, VContent::getImageInto() / VContent::loadAsync() accept:
+ * - QOI (`.qoi`): lossless, similar size to PNG, decodes several times faster (see QoiCodec.h)
+ * - Netpbm PAM (`P7`) and binary PPM (`P6`): uncompressed; an 8-bit file whose channel
+ *   count matches the request is read straight into the frame buffer
+ * - `.vcb` containers (see VContentMap.h)
+ *
+ * The format is chosen by file signature, not by extension. Anything that is not
+ * recognized, and PNGs the row decoder does not handle, is passed to VContent::getImage().
+ *
+ * Design notes:
+ * - Single-frame images; use `.vcb` (or VContentLoader::loadSequence()) for animations
+ * - 16-bit PNG and PAM/PPM samples are reduced to 8 bits (high byte); narrowing, alpha
+ *   premultiplication and 12-bit quantization run as one fused pass per row (VPixelKernels.h)
+ * - RGB files requested as RGBA get an opaque alpha channel; RGBA files requested as RGB
+ *   drop the alpha channel (`.vcb` files included)
+ * - A 12-bit `.vcb` file loads only with set12Bit; the 8-bit colors are gone
+ * - set12Bit stores each color channel >> 4 like VContent::getImage() (buffer stays 8-bit
+ *   per channel, alpha unchanged)
+ * - Convert an asset directory with the VContentConvert tool (`--batch`)
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/**
+ * @brief Image file formats recognized by signature.
+ */
+enum class VImageFormat :uint8_t
+{
+	UNKNOWN = 0,
+	PNG = 1, /**< "\x89PNG", see VContentFormat::loadPng(). */
+	QOI = 2, /**< "qoif". */
+	PAM = 3, /**< Netpbm "P7" (RGB / RGB_ALPHA) or "P6" (binary PPM). */
+	VCB = 4, /**< "VCB1" container, see VContentMap.h. */
+};
+
+/**
+ * @brief Basic image properties read from a file header.
+ */
+struct VImageInfo
+{
+	VImageFormat format = VImageFormat::UNKNOWN;
+	uint16_t width = 0;
+	uint16_t height = 0;
+	/** @brief Channels stored in the file (3 or 4). */
+	uint8_t channels = 0;
+	/** @brief Bits per channel stored in the file (8 or 16). */
+	uint8_t bit_depth = 8;
+};
+
+/*
+ * zlib inflate of the lodepng build inside libVContent (exported, used by getImage()).
+ * PNG rows are inflated with it and unfiltered here, so no extra library is linked.
+ */
+struct LodePNGDecompressSettings;
+extern const LodePNGDecompressSettings lodepng_default_decompress_settings;
+unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const unsigned char* in, size_t insize,
+	const LodePNGDecompressSettings* settings);
+
+namespace VContentFormat
+{
+	/** @brief Size of the QOI file header in bytes. */
+	constexpr size_t QOI_HEADER_SIZE = 14;
+
+	/** @brief QOI end marker (7 x 0x00, 0x01). */
+	constexpr uint8_t QOI_END[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	/** @brief Largest PAM/PPM header accepted, in bytes. */
+	constexpr size_t PAM_MAX_HEADER = 512;
+
+	/**
+	 * @brief Detect the format from the first bytes of a file.
+	 */
+	inline VImageFormat detect(const uint8_t* data, size_t size)
+	{
+		if (size >= 8 && memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0)
+			return VImageFormat::PNG;
+		if (size >= 4 && memcmp(data, "qoif", 4) == 0)
+			return VImageFormat::QOI;
+		if (size >= 4 && memcmp(data, "VCB1", 4) == 0)
+			return VImageFormat::VCB;
+		if (size >= 3 && data[0] == 'P' && (data[1] == '7' || data[1] == '6')
+			&& (data[2] == '\n' || data[2] == ' ' || data[2] == '\r' || data[2] == '\t'))
+			return VImageFormat::PAM;
+		return VImageFormat::UNKNOWN;
+	}
+
+	/**
+	 * @brief Detect the format of a file by its signature.
+	 *
+	 * @return Detected format; VImageFormat::UNKNOWN if the file cannot be read.
+	 */
+	inline VImageFormat detect(const std::string& path)
+	{
+		uint8_t sig[8];
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return VImageFormat::UNKNOWN;
+
+		ssize_t got = pread(fd, sig, sizeof(sig), 0);
+		::close(fd);
+		return got > 0 ? detect(sig, (size_t)got) : VImageFormat::UNKNOWN;
+	}
+
+	inline uint32_t readBE32(const uint8_t* p)
+	{
+		return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+	}
+
+	inline void writeBE32(uint8_t* p, uint32_t v)
+	{
+		p[0] = (uint8_t)(v >> 24);
+		p[1] = (uint8_t)(v >> 16);
+		p[2] = (uint8_t)(v >> 8);
+		p[3] = (uint8_t)v;
+	}
+
+	/**
+	 * @brief Parse a PAM ("P7") or binary PPM ("P6") header.
+	 *
+	 * @param data First bytes of the file.
+	 * @param size Number of bytes in @p data.
+	 * @param info Parsed properties.
+	 * @param data_offset Offset of the first pixel byte.
+	 *
+	 * @return true if the header is complete and describes an RGB/RGBA image
+	 *         with 8-bit (MAXVAL 255) or 16-bit (MAXVAL 65535) samples.
+	 */
+	inline bool parsePam(const uint8_t* data, size_t size, VImageInfo& info, size_t& data_offset)
+	{
+		if (detect(data, size) != VImageFormat::PAM)
+			return false;
+
+		const bool is_pam = data[1] == '7';
+		size_t p = 2;
+
+		// next whitespace-separated token, skipping '#' comments
+		auto token = [&](std::string& out) -> bool {
+			out.clear();
+			while (p < size)
+			{
+				if (data[p] == '#')
+				{
+					while (p < size && data[p] != '\n')
+						p++;
+				}
+				else if (data[p] == ' ' || data[p] == '\n' || data[p] == '\r' || data[p] == '\t')
+					p++;
+				else
+					break;
+			}
+			while (p < size && data[p] != ' ' && data[p] != '\n' && data[p] != '\r' && data[p] != '\t')
+				out.push_back((char)data[p++]);
+			return !out.empty() && p < size;
+		};
+
+		auto number = [&](long& value) -> bool {
+			std::string t;
+			if (!token(t) || t.size() > 9 || t.find_first_not_of("0123456789") != std::string::npos)
+				return false;
+			value = atol(t.c_str());
+			return true;
+		};
+
+		long width = 0, height = 0, depth = 3, maxval = 0;
+		if (is_pam)
+		{
+			std::string key, tuple;
+			while (true)
+			{
+				if (!token(key))
+					return false;
+				if (key == "ENDHDR")
+					break;
+				if (key == "WIDTH" && !number(width))
+					return false;
+				else if (key == "HEIGHT" && !number(height))
+					return false;
+				else if (key == "DEPTH" && !number(depth))
+					return false;
+				else if (key == "MAXVAL" && !number(maxval))
+					return false;
+				else if (key == "TUPLTYPE" && !token(tuple))
+					return false;
+			}
+
+			// ENDHDR is followed by exactly one newline
+			if (data[p] != '\n')
+				return false;
+			p++;
+		}
+		else
+		{
+			if (!number(width) || !number(height) || !number(maxval))
+				return false;
+
+			// the maxval is followed by exactly one whitespace character
+			p++;
+		}
+
+		if (width <= 0 || width > 0xffff || height <= 0 || height > 0xffff)
+			return false;
+		if ((depth != 3 && depth != 4) || (maxval != 255 && maxval != 65535))
+			return false;
+
+		info.format = VImageFormat::PAM;
+		info.width = (uint16_t)width;
+		info.height = (uint16_t)height;
+		info.channels = (uint8_t)depth;
+		info.bit_depth = maxval == 255 ? 8 : 16;
+		data_offset = p;
+		return true;
+	}
+
+	/**
+	 * @brief Read basic image properties from a file header.
+	 *
+	 * Supports PNG, QOI, PAM/PPM and `.vcb` files.
+	 *
+	 * @return true if the format was recognized and the header is valid.
+	 */
+	inline bool probe(const std::string& path, VImageInfo& info)
+	{
+		uint8_t head[PAM_MAX_HEADER];
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		ssize_t got = pread(fd, head, sizeof(head), 0);
+		::close(fd);
+		if (got <= 0)
+			return false;
+
+		const size_t size = (size_t)got;
+		info = VImageInfo();
+		info.format = detect(head, size);
+		switch (info.format)
+		{
+		case VImageFormat::PNG:
+			// IHDR: width, height (BE32), bit depth, color type (2 = RGB, 6 = RGBA)
+			if (size < 26 || memcmp(head + 12, "IHDR", 4) != 0 || (head[25] != 2 && head[25] != 6))
+				return false;
+			if (readBE32(head + 16) > 0xffff || readBE32(head + 20) > 0xffff)
+				return false;
+			info.width = (uint16_t)readBE32(head + 16);
+			info.height = (uint16_t)readBE32(head + 20);
+			info.bit_depth = head[24];
+			info.channels = head[25] == 6 ? 4 : 3;
+			return info.bit_depth == 8 || info.bit_depth == 16;
+
+		case VImageFormat::QOI:
+			if (size < QOI_HEADER_SIZE || readBE32(head + 4) > 0xffff || readBE32(head + 8) > 0xffff)
+				return false;
+			info.width = (uint16_t)readBE32(head + 4);
+			info.height = (uint16_t)readBE32(head + 8);
+			info.channels = head[12];
+			return info.channels == 3 || info.channels == 4;
+
+		case VImageFormat::PAM:
+		{
+			size_t offset;
+			return parsePam(head, size, info, offset);
+		}
+
+		case VImageFormat::VCB:
+		{
+			VcbHeader header;
+			if (size < sizeof(header))
+				return false;
+			memcpy(&header, head, sizeof(header));
+			if (header.format > (uint8_t)VcbFormat::RGBA8888 || !VContentFile::isValid(header, UINT64_MAX))
+				return false;
+			info.width = header.width;
+			info.height = header.height;
+			info.channels = header.alpha ? 4 : 3;
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	/** @brief Rows converted per read when a PAM/PPM file needs conversion. */
+	constexpr size_t PAM_ROW_BLOCK = 16;
+
+	/**
+	 * @brief VPixelKernels flags for load options.
+	 */
+	inline uint8_t pixelFlags(const VContentLoadOptions& options)
+	{
+		return (uint8_t)((options.premultiply && options.isRGBA ? VPIXEL_PREMULTIPLY : 0)
+			| (options.set12Bit ? VPIXEL_12BIT : 0));
+	}
+
+	inline void setSingleFrame(VContent& target, const std::string& path, uint16_t width, uint16_t height,
+		bool isRGBA, bool set12Bit)
+	{
+		target.frames.resize(1);
+		target.active_frame_id = 0;
+		target.ft = 1;
+		// a reused target keeps nothing of its previous content's playback settings
+		target.ratio = 1;
+		target.loop = 0;
+		target.width = width;
+		target.height = height;
+		target.path = path;
+		target.alpha = isRGBA;
+		target.color12Bit = set12Bit;
+	}
+
+	/**
+	 * @brief Load a QOI file.
+	 *
+	 * @param target Content to load into; the frame buffer capacity is reused.
+	 * @param path Path to the `.qoi` file.
+	 * @param options Load options; isRGBA selects 4 or 3 channels.
+	 *
+	 * @return true if content was loaded successfully; false otherwise.
+	 */
+	inline bool loadQoi(VContent& target, const std::string& path, const VContentLoadOptions& options)
+	{
+		VContentAccess::setLoaded(target, false);
+
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		std::vector<uint8_t> file;
+		bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size > QOI_HEADER_SIZE;
+		if (ok)
+		{
+			file.resize((size_t)st.st_size);
+			ok = pread(fd, file.data(), file.size(), 0) == (ssize_t)file.size();
+		}
+		::close(fd);
+
+		if (!ok || detect(file.data(), file.size()) != VImageFormat::QOI)
+			return false;
+
+		const uint32_t width = readBE32(file.data() + 4);
+		const uint32_t height = readBE32(file.data() + 8);
+		if (width == 0 || width > 0xffff || height == 0 || height > 0xffff)
+			return false;
+
+		// QoiCodec decodes to either channel count, whatever the file stores
+		const uint8_t channels = options.isRGBA ? 4 : 3;
+		const size_t pixels = (size_t)width * height;
+		setSingleFrame(target, path, (uint16_t)width, (uint16_t)height, options.isRGBA, options.set12Bit);
+		target.frames[0].resize(pixels * channels);
+		if (!QoiCodec::decode(file.data() + QOI_HEADER_SIZE, file.size() - QOI_HEADER_SIZE,
+			target.frames[0].data(), pixels, channels))
+			return false;
+
+		const uint8_t flags = pixelFlags(options);
+		if (flags != 0)
+		{
+			uint8_t* row = target.frames[0].data();
+			for (uint32_t y = 0; y < height; y++, row += (size_t)width * channels)
+				VPixelKernels::convertRow(row, channels, false, row, channels, width, flags);
+		}
+
+		VContentAccess::setLoaded(target, true);
+		return true;
+	}
+
+	/**
+	 * @brief Load a PAM ("P7") or binary PPM ("P6") file.
+	 *
+	 * 8-bit files with the requested channel count and no processing are read directly
+	 * into the frame buffer; other files are read in blocks of PAM_ROW_BLOCK rows and
+	 * converted with VPixelKernels::convertRow().
+	 *
+	 * @param target Content to load into; the frame buffer capacity is reused.
+	 * @param path Path to the `.pam` / `.ppm` file.
+	 * @param options Load options; isRGBA selects 4 or 3 channels.
+	 *
+	 * @return true if content was loaded successfully; false otherwise.
+	 */
+	inline bool loadPam(VContent& target, const std::string& path, const VContentLoadOptions& options)
+	{
+		VContentAccess::setLoaded(target, false);
+
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		uint8_t head[PAM_MAX_HEADER];
+		ssize_t got = pread(fd, head, sizeof(head), 0);
+		VImageInfo info;
+		size_t offset = 0;
+		if (got <= 0 || !parsePam(head, (size_t)got, info, offset))
+		{
+			::close(fd);
+			return false;
+		}
+
+		const uint8_t channels = options.isRGBA ? 4 : 3;
+		const uint8_t flags = pixelFlags(options);
+		const size_t pixels = (size_t)info.width * info.height;
+		const size_t src_row = (size_t)info.width * info.channels * (info.bit_depth / 8);
+		const size_t dst_row = (size_t)info.width * channels;
+		setSingleFrame(target, path, info.width, info.height, options.isRGBA, options.set12Bit);
+		target.frames[0].resize(pixels * channels);
+		uint8_t* dst = target.frames[0].data();
+
+		bool ok;
+		if (info.bit_depth == 8 && info.channels == channels)
+		{
+			// same layout: read in place, then process each row while it is in cache
+			ok = pread(fd, dst, pixels * channels, (off_t)offset) == (ssize_t)(pixels * channels);
+			for (uint16_t y = 0; ok && flags != 0 && y < info.height; y++)
+				VPixelKernels::convertRow(dst + dst_row * y, channels, false, dst + dst_row * y, channels, info.width, flags);
+		}
+		else
+		{
+			std::vector<uint8_t> block(src_row * PAM_ROW_BLOCK);
+			ok = true;
+			for (uint16_t y = 0; ok && y < info.height; y += PAM_ROW_BLOCK)
+			{
+				const size_t rows = (size_t)(info.height - y) < PAM_ROW_BLOCK ? (size_t)(info.height - y) : PAM_ROW_BLOCK;
+				const off_t at = (off_t)(offset + src_row * y);
+				ok = pread(fd, block.data(), src_row * rows, at) == (ssize_t)(src_row * rows);
+				for (size_t r = 0; ok && r < rows; r++)
+				{
+					VPixelKernels::convertRow(block.data() + src_row * r, info.channels, info.bit_depth == 16,
+						dst + dst_row * (y + r), channels, info.width, flags);
+				}
+			}
+		}
+		::close(fd);
+
+		VContentAccess::setLoaded(target, ok);
+		return ok;
+	}
+
+	/**
+	 * @brief Undo the PNG filter of one row in place.
+	 *
+	 * @param row Filtered row bytes (without the filter type byte).
+	 * @param prev Previous, already unfiltered row (zeros for the first row).
+	 * @param bytes Bytes per row.
+	 * @param bpp Bytes per pixel (at least 1).
+	 * @param filter PNG filter type (0-4).
+	 *
+	 * @return false for an unknown filter type.
+	 */
+	inline bool unfilterPngRow(uint8_t* row, const uint8_t* prev, size_t bytes, size_t bpp, uint8_t filter)
+	{
+		switch (filter)
+		{
+		case 0:
+			return true;
+		case 1:
+			for (size_t i = bpp; i < bytes; i++)
+				row[i] = (uint8_t)(row[i] + row[i - bpp]);
+			return true;
+		case 2:
+			for (size_t i = 0; i < bytes; i++)
+				row[i] = (uint8_t)(row[i] + prev[i]);
+			return true;
+		case 3:
+			for (size_t i = 0; i < bpp; i++)
+				row[i] = (uint8_t)(row[i] + (prev[i] >> 1));
+			for (size_t i = bpp; i < bytes; i++)
+				row[i] = (uint8_t)(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+			return true;
+		case 4:
+			for (size_t i = 0; i < bpp; i++)
+				row[i] = (uint8_t)(row[i] + prev[i]);
+			for (size_t i = bpp; i < bytes; i++)
+			{
+				const int a = row[i - bpp], b = prev[i], c = prev[i - bpp];
+				const int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+				row[i] = (uint8_t)(row[i] + (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/**
+	 * @brief Load a PNG file, or anything else VContent::getImage() decodes.
+	 *
+	 * Non-interlaced 8/16-bit RGB and RGBA PNGs are inflated in one call, then each row
+	 * is unfiltered and passed to VPixelKernels::convertRow() while it is in cache, so
+	 * 16-bit narrowing, alpha conversion, premultiplication and 12-bit quantization cost
+	 * no extra pass. Other files (palette, gray, interlaced, animated) go through
+	 * VContent::getImage().
+	 *
+	 * @param target Content to load into; the frame buffer capacity is reused by the
+	 *        row decoder.
+	 * @param path Path to the image file.
+	 * @param options Load options; isRGBA selects 4 or 3 channels.
+	 *
+	 * @return true if content was loaded successfully; false otherwise.
+	 */
+	inline bool loadPng(VContent& target, const std::string& path, const VContentLoadOptions& options)
+	{
+		std::vector<uint8_t> file;
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+			struct stat st;
+			if (fstat(fd, &st) == 0 && st.st_size > 33)
+			{
+				file.resize((size_t)st.st_size);
+				if (pread(fd, file.data(), file.size(), 0) != (ssize_t)file.size())
+					file.clear();
+			}
+			::close(fd);
+		}
+
+		// IHDR first: width, height (BE32), bit depth, color type (2 = RGB, 6 = RGBA),
+		// compression, filter, interlace
+		bool direct = file.size() > 33 && detect(file.data(), file.size()) == VImageFormat::PNG
+			&& memcmp(file.data() + 12, "IHDR", 4) == 0;
+		const uint8_t* ihdr = file.data() + 16;
+		uint32_t width = 0, height = 0;
+		if (direct)
+		{
+			width = readBE32(ihdr);
+			height = readBE32(ihdr + 4);
+			direct = width > 0 && width <= 0xffff && height > 0 && height <= 0xffff
+				&& (ihdr[8] == 8 || ihdr[8] == 16) && (ihdr[9] == 2 || ihdr[9] == 6) && ihdr[12] == 0;
+		}
+
+		// concatenate the IDAT payloads; an acTL chunk marks an animated PNG
+		std::vector<uint8_t> idat;
+		for (size_t p = 8; direct; )
+		{
+			if (file.size() - p < 12 || readBE32(file.data() + p) > file.size() - p - 12)
+			{
+				direct = false;
+				break;
+			}
+			const uint32_t len = readBE32(file.data() + p);
+			const uint8_t* type = file.data() + p + 4;
+			if (memcmp(type, "IDAT", 4) == 0)
+				idat.insert(idat.end(), type + 4, type + 4 + len);
+			else if (memcmp(type, "acTL", 4) == 0)
+				direct = false;
+			else if (memcmp(type, "IEND", 4) == 0)
+				break;
+			p += 12 + (size_t)len;
+		}
+
+		if (!direct)
+		{
+			if (!options.premultiply || !options.isRGBA)
+			{
+				target = VContent::getImage(path, options.isRGBA, options.set12Bit);
+				return target.isReady();
+			}
+
+			// quantize after premultiplying, both in one pass over the decoded rows
+			target = VContent::getImage(path, true, false);
+			if (!target.isReady())
+				return false;
+			for (auto& frame : target.frames)
+			{
+				for (size_t y = 0; y < target.height; y++)
+				{
+					uint8_t* row = frame.data() + (size_t)target.width * 4 * y;
+					VPixelKernels::convertRow(row, 4, false, row, 4, target.width, pixelFlags(options));
+				}
+			}
+			target.color12Bit = options.set12Bit;
+			return true;
+		}
+
+		VContentAccess::setLoaded(target, false);
+		const bool is16 = ihdr[8] == 16;
+		const uint8_t src_channels = ihdr[9] == 6 ? 4 : 3;
+		std::vector<uint8_t>().swap(file); // only idat is needed from here on
+
+		uint8_t* raw = nullptr;
+		size_t raw_size = 0;
+		const size_t bpp = (size_t)src_channels * (is16 ? 2 : 1);
+		const size_t src_row = (size_t)width * bpp;
+		if (lodepng_zlib_decompress(&raw, &raw_size, idat.data(), idat.size(), &lodepng_default_decompress_settings) != 0
+			|| raw_size < (src_row + 1) * height)
+		{
+			free(raw);
+			return false;
+		}
+
+		const uint8_t channels = options.isRGBA ? 4 : 3;
+		const uint8_t flags = pixelFlags(options);
+		const size_t dst_row = (size_t)width * channels;
+		setSingleFrame(target, path, (uint16_t)width, (uint16_t)height, options.isRGBA, options.set12Bit);
+		target.frames[0].resize(dst_row * height);
+		uint8_t* dst = target.frames[0].data();
+
+		// rows stay in the inflated buffer: each one is the "previous row" of the next
+		std::vector<uint8_t> zero(src_row, 0);
+		const uint8_t* prev = zero.data();
+		bool ok = true;
+		for (uint32_t y = 0; ok && y < height; y++)
+		{
+			uint8_t* row = raw + (src_row + 1) * y;
+			ok = unfilterPngRow(row + 1, prev, src_row, bpp, row[0]);
+			if (ok)
+				VPixelKernels::convertRow(row + 1, src_channels, is16, dst + dst_row * y, channels, width, flags);
+			prev = row + 1;
+		}
+		free(raw);
+
+		VContentAccess::setLoaded(target, ok);
+		return ok;
+	}
+
+	inline int8_t writeFile(const std::string& path, const uint8_t* head, size_t head_size,
+		const uint8_t* data, size_t size, const uint8_t* tail, size_t tail_size)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return -2;
+
+		bool ok = fwrite(head, 1, head_size, file) == head_size;
+		ok = ok && fwrite(data, 1, size, file) == size;
+		ok = ok && (tail_size == 0 || fwrite(tail, 1, tail_size, file) == tail_size);
+		if (fclose(file) != 0)
+			ok = false;
+		return ok ? 0 : -3;
+	}
+
+	/**
+	 * @brief Save one frame of loaded content as a QOI file.
+	 *
+	 * @param content Loaded RGB or RGBA content.
+	 * @param path Output file path.
+	 * @param index Frame index.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : frame missing or size does not match width/height
+	 * - -2 : file open failed
+	 * - -3 : write failed
+	 */
+	inline int8_t saveQoi(const VContent& content, const std::string& path, uint16_t index = 0)
+	{
+		const uint8_t channels = content.alpha ? 4 : 3;
+		const size_t pixels = (size_t)content.width * content.height;
+		if (index >= content.frames.size() || pixels == 0 || content.frames[index].size() != pixels * channels)
+			return -1;
+
+		uint8_t head[QOI_HEADER_SIZE];
+		memcpy(head, "qoif", 4);
+		writeBE32(head + 4, content.width);
+		writeBE32(head + 8, content.height);
+		head[12] = channels;
+		head[13] = 0; // sRGB with linear alpha
+
+		std::vector<uint8_t> chunks;
+		QoiCodec::encode(content.frames[index].data(), pixels, channels, chunks);
+		return writeFile(path, head, sizeof(head), chunks.data(), chunks.size(), QOI_END, sizeof(QOI_END));
+	}
+
+	/**
+	 * @brief Save one frame of loaded content as an uncompressed PAM ("P7") file.
+	 *
+	 * @param content Loaded RGB or RGBA content.
+	 * @param path Output file path.
+	 * @param index Frame index.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : frame missing or size does not match width/height
+	 * - -2 : file open failed
+	 * - -3 : write failed
+	 */
+	inline int8_t savePam(const VContent& content, const std::string& path, uint16_t index = 0)
+	{
+		const uint8_t channels = content.alpha ? 4 : 3;
+		const size_t pixels = (size_t)content.width * content.height;
+		if (index >= content.frames.size() || pixels == 0 || content.frames[index].size() != pixels * channels)
+			return -1;
+
+		char head[128];
+		int len = snprintf(head, sizeof(head), "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n",
+			(unsigned)content.width, (unsigned)content.height, (unsigned)channels, content.alpha ? "RGB_ALPHA" : "RGB");
+		return writeFile(path, (const uint8_t*)head, (size_t)len, content.frames[index].data(),
+			content.frames[index].size(), nullptr, 0);
+	}
+};
+
+inline bool VContent::getImageInto(VContent& target, const std::string& path, bool isRGBA, bool set12Bit)
+{
+	VContentLoadOptions options;
+	options.isRGBA = isRGBA;
+	options.set12Bit = set12Bit;
+	return getImageInto(target, path, options);
+}
+
+inline bool VContent::getImageInto(VContent& target, const std::string& path, const VContentLoadOptions& options)
+{
+	switch (VContentFormat::detect(path))
+	{
+	case VImageFormat::QOI:
+		return VContentFormat::loadQoi(target, path, options);
+
+	case VImageFormat::PAM:
+		return VContentFormat::loadPam(target, path, options);
+
+	case VImageFormat::VCB:
+		break;
+
+	default:
+		return VContentFormat::loadPng(target, path, options);
+	}
+
+	// open() validates the header (format, alpha and frame size, see VContentFile::isValid())
+	VContentAccess::setLoaded(target, false);
+	VContentMap mapped;
+	if (mapped.open(path) != 0 || mapped.header().format > (uint8_t)VcbFormat::RGBA8888)
+		return false;
+
+	const VcbHeader& h = mapped.header();
+	if (h.color12Bit != 0 && !options.set12Bit)
+		return false;
+
+	// resize() keeps the existing frame vectors, assign() reuses their capacity;
+	// alpha conversion, premultiplication and quantization are fused into the copy
+	const uint8_t src_channels = h.alpha ? 4 : 3;
+	const uint8_t channels = options.isRGBA ? 4 : 3;
+	uint8_t flags = VContentFormat::pixelFlags(options);
+	if (h.color12Bit != 0)
+		flags &= (uint8_t)~VPIXEL_12BIT; // already quantized
+	const size_t pixels = (size_t)h.width * h.height;
+	target.frames.resize(h.ft);
+	for (uint16_t i = 0; i < h.ft; i++)
+	{
+		VFrameView view = mapped.frame(i);
+		if (flags != 0 || src_channels != channels)
+		{
+			target.frames[i].resize(pixels * channels);
+			VPixelKernels::convertRow(view.data, src_channels, false, target.frames[i].data(), channels, pixels, flags);
+		}
+		else
+			target.frames[i].assign(view.begin(), view.end());
+	}
+
+	target.active_frame_id = 0;
+	target.ft = h.ft;
+	target.width = h.width;
+	target.height = h.height;
+	target.path = path;
+	target.alpha = options.isRGBA;
+	target.color12Bit = options.set12Bit;
+	target.ratio = h.ratio;
+	target.loop = h.loop;
+	VContentAccess::setLoaded(target, true);
+	return true;
+}
@@ -0,0 +1,316 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "VContent.h"
+#include "VContentFormats.h"
+
+/**
+ * @file VContentLoader.h
+ * @brief Background and parallel VContent loading.
+ *
+ * Loads single images off the calling thread (VContent::loadAsync()) and animation
+ * sequences stored as one image file per frame. Frame files are decoded concurrently
+ * on a small shared worker pool and moved into pre-sized frame slots, so a long
+ * sequence neither blocks the calling thread nor decodes one frame after another.
+ *
+ * Design notes:
+ * - Singleton-style worker pool (namespace API; no instances), started on first use
+ * - Pool size is the number of cores, capped at VCONTENT_LOADER_MAX_THREADS
+ * - Each frame file must decode to exactly one frame; all frames must have the same size
+ *
+ * Threading notes:
+ * - Completion callbacks are invoked from a loader worker thread
+ * - Loads started from a worker thread (a completion callback, or a task waiting on
+ *   the future of loadAsync() / loadSequence()) run synchronously on that thread; the
+ *   pool is small (VCONTENT_LOADER_MAX_THREADS), and queueing them could leave every
+ *   worker waiting for a task no worker is free to run
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/** @brief Upper bound for the loader worker pool size. */
+constexpr unsigned int VCONTENT_LOADER_MAX_THREADS = 4;
+
+namespace VContentLoader
+{
+	/**
+	 * @brief Fixed-size worker pool shared by all loader calls.
+	 */
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(unsigned int count)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				workers.emplace_back([this] { run(); });
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				stopping = true;
+			}
+			cond.notify_all();
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		void post(std::function<void()> task)
+		{
+			// nested load: run in place, the caller may block this worker on the result
+			if (current() == this)
+			{
+				task();
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				tasks.push(std::move(task));
+			}
+			cond.notify_one();
+		}
+
+		size_t size() const { return workers.size(); }
+
+	private:
+		// pool the calling thread belongs to, nullptr outside any pool
+		static WorkerPool*& current()
+		{
+			thread_local WorkerPool* pool = nullptr;
+			return pool;
+		}
+
+		void run()
+		{
+			current() = this;
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lk(mtx);
+					cond.wait(lk, [this] { return stopping || !tasks.empty(); });
+					if (tasks.empty())
+						return;
+					task = std::move(tasks.front());
+					tasks.pop();
+				}
+				task();
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex mtx;
+		std::condition_variable cond;
+		bool stopping = false;
+	};
+
+	/**
+	 * @brief Shared worker pool, created on first use.
+	 */
+	inline WorkerPool& pool()
+	{
+		static WorkerPool instance([] {
+			unsigned int cores = std::thread::hardware_concurrency();
+			if (cores == 0)
+				cores = 1;
+			return cores < VCONTENT_LOADER_MAX_THREADS ? cores : VCONTENT_LOADER_MAX_THREADS;
+		}());
+		return instance;
+	}
+
+	/**
+	 * @brief Load one image on the worker pool and report the result via callback.
+	 *
+	 * @param path Path to the image file (PNG, QOI, PAM/PPM or `.vcb`).
+	 * @param options Load options.
+	 * @param onComplete Called once with the loaded content (check isReady()).
+	 */
+	inline void load(const std::string& path, const VContentLoadOptions& options,
+		std::function<void(VContent&&)> onComplete)
+	{
+		pool().post([path, options, onComplete = std::move(onComplete)] {
+			VContent content;
+			VContent::getImageInto(content, path, options);
+			onComplete(std::move(content));
+		});
+	}
+
+	/**
+	 * @brief Check a framePaths() pattern.
+	 *
+	 * @return true if @p pattern holds exactly one `%d` conversion, optionally with a
+	 * zero flag and a width below 100 (`%d`, `%3d`, `%03d`), and no conversion other
+	 * than `%%`.
+	 */
+	inline bool isFramePattern(const std::string& pattern)
+	{
+		int conversions = 0;
+		for (size_t i = 0; i < pattern.size(); i++)
+		{
+			if (pattern[i] != '%')
+				continue;
+			if (++i < pattern.size() && pattern[i] == '%')
+				continue;
+
+			if (i < pattern.size() && pattern[i] == '0')
+				i++;
+			for (int digits = 0; i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9'; digits++, i++)
+			{
+				if (digits == 2)
+					return false;
+			}
+			if (i >= pattern.size() || pattern[i] != 'd')
+				return false;
+			conversions++;
+		}
+		return conversions == 1;
+	}
+
+	/**
+	 * @brief Build frame file paths from a printf-style pattern.
+	 *
+	 * Example: framePaths("/.doly/images/intro/%03d.png", 60) -> 000.png ... 059.png
+	 *
+	 * @param pattern Path pattern with one integer conversion (see isFramePattern()).
+	 * @param count Number of frames.
+	 * @param first Index of the first frame.
+	 *
+	 * @return Frame file paths; empty if @p pattern is not a valid frame pattern.
+	 */
+	inline std::vector<std::string> framePaths(const std::string& pattern, uint16_t count, int first = 0)
+	{
+		std::vector<std::string> paths;
+		if (!isFramePattern(pattern))
+			return paths;
+
+		paths.reserve(count);
+		for (int i = 0; i < count; i++)
+		{
+			int len = snprintf(nullptr, 0, pattern.c_str(), first + i);
+			std::string path(len > 0 ? (size_t)len : 0, '\0');
+			snprintf(path.data(), path.size() + 1, pattern.c_str(), first + i);
+			paths.push_back(std::move(path));
+		}
+		return paths;
+	}
+
+	/**
+	 * @brief Decode a frame sequence on the worker pool and report the result via callback.
+	 *
+	 * @param paths One image file per frame, in playback order.
+	 * @param isRGBA True if the images contain an alpha channel.
+	 * @param set12Bit If true, convert images to 12-bit color depth.
+	 * @param onComplete Called once with the loaded content; the content is not ready
+	 *        (isReady() == false) if any frame failed, frame sizes differ or there are
+	 *        more than 65535 frames.
+	 */
+	inline void loadSequence(const std::vector<std::string>& paths, bool isRGBA, bool set12Bit,
+		std::function<void(VContent&&)> onComplete)
+	{
+		struct Job
+		{
+			VContent content;
+			std::vector<uint16_t> widths, heights;
+			std::atomic<size_t> remaining{ 0 };
+			std::atomic<bool> failed{ false };
+			std::function<void(VContent&&)> onComplete;
+		};
+
+		auto job = std::make_shared<Job>();
+		job->onComplete = std::move(onComplete);
+		if (paths.empty() || paths.size() > 0xffff)
+		{
+			job->onComplete(std::move(job->content));
+			return;
+		}
+
+		// pre-sized slots, each worker only touches its own index
+		job->content.frames.resize(paths.size());
+		job->widths.resize(paths.size());
+		job->heights.resize(paths.size());
+		job->remaining = paths.size();
+
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			pool().post([job, i, path = paths[i], isRGBA, set12Bit, first = paths[0]] {
+				if (!job->failed.load(std::memory_order_relaxed))
+				{
+					VContent frame = VContent::getImage(path, isRGBA, set12Bit);
+					if (frame.isReady() && frame.frames.size() == 1)
+					{
+						job->content.frames[i] = std::move(frame.frames[0]);
+						job->widths[i] = frame.width;
+						job->heights[i] = frame.height;
+					}
+					else
+						job->failed.store(true, std::memory_order_relaxed);
+				}
+
+				if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+					return;
+
+				// last frame done, finalize on this worker
+				VContent& content = job->content;
+				bool ok = !job->failed.load(std::memory_order_relaxed);
+				for (size_t n = 1; ok && n < content.frames.size(); n++)
+					ok = job->widths[n] == job->widths[0] && job->heights[n] == job->heights[0];
+
+				if (ok)
+				{
+					content.ft = (uint16_t)content.frames.size();
+					content.width = job->widths[0];
+					content.height = job->heights[0];
+					content.path = first;
+					content.alpha = isRGBA;
+					content.color12Bit = set12Bit;
+				}
+				else
+					content.frames.clear();
+
+				VContentAccess::setLoaded(content, ok);
+				job->onComplete(std::move(content));
+			});
+		}
+	}
+
+	/**
+	 * @brief Decode a frame sequence on the worker pool.
+	 *
+	 * @param paths One image file per frame, in playback order.
+	 * @param isRGBA True if the images contain an alpha channel.
+	 * @param set12Bit If true, convert images to 12-bit color depth.
+	 *
+	 * @return Future for the loaded content; check VContent::isReady() on the result.
+	 */
+	inline std::future<VContent> loadSequence(const std::vector<std::string>& paths, bool isRGBA, bool set12Bit)
+	{
+		auto promise = std::make_shared<std::promise<VContent>>();
+		std::future<VContent> result = promise->get_future();
+		loadSequence(paths, isRGBA, set12Bit, [promise](VContent&& content) {
+			promise->set_value(std::move(content));
+		});
+		return result;
+	}
+};
+
+inline std::future<VContent> VContent::loadAsync(const std::string& path, const VContentLoadOptions& options)
+{
+	auto promise = std::make_shared<std::promise<VContent>>();
+	std::future<VContent> result = promise->get_future();
+	VContentLoader::load(path, options, [promise](VContent&& content) {
+		promise->set_value(std::move(content));
+	});
+	return result;
+}
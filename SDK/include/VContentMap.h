@@ -0,0 +1,420 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "VContent.h"
+
+/**
+ * @file VContentMap.h
+ * @brief Binary `.vcb` container for VContent and zero-copy memory mapping.
+ *
+ * A `.vcb` file holds the VContent header fields followed by the raw frames, already in
+ * the byte layout produced by VContent::getImage(). Loading it is a single mmap():
+ * no PNG inflate, no per-frame allocation and no copy.
+ *
+ * File layout (little-endian):
+ * - VcbHeader (64 bytes)
+ * - frame 0 at VcbHeader::data_offset, frame N at data_offset + N * frame_stride
+ *
+ * Design notes:
+ * - data_offset and frame_stride are multiples of VCB_ALIGN (64 bytes), so every mapped
+ *   frame starts on a cache line
+ * - Create files with VContentFile::save() or the VContentConvert tool
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/** @brief Alignment of the frame data inside a `.vcb` file, in bytes. */
+constexpr uint32_t VCB_ALIGN = 64;
+
+/** @brief Current `.vcb` format version. */
+constexpr uint16_t VCB_VERSION = 1;
+
+/**
+ * @brief Pixel layout of the frames stored in a `.vcb` file.
+ */
+enum class VcbFormat :uint8_t
+{
+	RGB888 = 0,   /**< 3 bytes per pixel, as VContent::getImage(isRGBA = false). */
+	RGBA8888 = 1, /**< 4 bytes per pixel, as VContent::getImage(isRGBA = true). */
+	LCD12 = 2,    /**< LcdControl buffer format for LcdColorDepth::L12BIT (see VLcdContent.h). */
+	LCD18 = 3,    /**< LcdControl buffer format for LcdColorDepth::L18BIT (see VLcdContent.h). */
+};
+
+/**
+ * @brief On-disk `.vcb` header.
+ */
+struct VcbHeader
+{
+	/** @brief File signature, always "VCB1". */
+	char magic[4];
+	/** @brief Format version (VCB_VERSION). */
+	uint16_t version;
+	/** @brief Size of this header in bytes. */
+	uint16_t header_size;
+	/** @brief Frame width in pixels. */
+	uint16_t width;
+	/** @brief Frame height in pixels. */
+	uint16_t height;
+	/** @brief Total number of frames. */
+	uint16_t ft;
+	/** @brief Loop count (see VContent::loop). */
+	uint16_t loop;
+	/** @brief Frame rate divider (see VContent::ratio). */
+	uint8_t ratio;
+	/** @brief 1 if frames have an alpha channel. */
+	uint8_t alpha;
+	/** @brief 1 if frames were quantized to 12-bit color. */
+	uint8_t color12Bit;
+	/** @brief Pixel layout (VcbFormat). */
+	uint8_t format;
+	/** @brief Bytes of pixel data per frame. */
+	uint32_t frame_size;
+	/** @brief Distance between two frames in bytes (frame_size rounded up to VCB_ALIGN). */
+	uint32_t frame_stride;
+	/** @brief Offset of frame 0 from the start of the file. */
+	uint32_t data_offset;
+	/** @brief Reserved, written as zero. */
+	uint32_t reserved[8];
+};
+
+static_assert(sizeof(VcbHeader) == VCB_ALIGN, "VcbHeader must be exactly one alignment unit");
+
+namespace VContentFile
+{
+	/**
+	 * @brief Round a size up to the `.vcb` frame alignment.
+	 */
+	inline uint32_t alignedSize(uint32_t size)
+	{
+		return (size + VCB_ALIGN - 1) & ~(VCB_ALIGN - 1);
+	}
+
+	/**
+	 * @brief Bytes per frame of a pixel layout.
+	 *
+	 * @param format Pixel layout (VcbFormat).
+	 * @param width Frame width in pixels.
+	 * @param height Frame height in pixels.
+	 *
+	 * @return Frame size in bytes; 0 for an unknown format or an LCD12 frame with an odd
+	 * pixel count.
+	 */
+	inline uint64_t frameSize(uint8_t format, uint16_t width, uint16_t height)
+	{
+		const uint64_t pixels = (uint64_t)width * height;
+		switch ((VcbFormat)format)
+		{
+		case VcbFormat::RGB888: return pixels * 3;
+		case VcbFormat::RGBA8888: return pixels * 4;
+		case VcbFormat::LCD12: return pixels % 2 == 0 ? pixels * 3 / 2 : 0;
+		case VcbFormat::LCD18: return pixels * 3;
+		default: return 0;
+		}
+	}
+
+	/**
+	 * @brief Validate a header against the size of the file that contains it.
+	 *
+	 * @param header Header to check.
+	 * @param file_size Total file size in bytes.
+	 *
+	 * @return true if the header is consistent (known format, alpha and color depth
+	 * matching the format, frame_size matching width and height) and all frames are
+	 * inside the file.
+	 */
+	inline bool isValid(const VcbHeader& header, uint64_t file_size)
+	{
+		if (memcmp(header.magic, "VCB1", 4) != 0 || header.version != VCB_VERSION)
+			return false;
+
+		if (header.header_size != sizeof(VcbHeader) || header.data_offset < sizeof(VcbHeader))
+			return false;
+
+		if (header.ft == 0 || header.frame_size == 0 || header.frame_stride < header.frame_size)
+			return false;
+
+		// only RGBA8888 has alpha; the LCD formats fix the color depth
+		const VcbFormat format = (VcbFormat)header.format;
+		if (header.alpha != (format == VcbFormat::RGBA8888 ? 1 : 0) || header.color12Bit > 1)
+			return false;
+		if ((format == VcbFormat::LCD12 && header.color12Bit != 1) || (format == VcbFormat::LCD18 && header.color12Bit != 0))
+			return false;
+		if (header.frame_size != frameSize(header.format, header.width, header.height))
+			return false;
+
+		uint64_t end = (uint64_t)header.data_offset + (uint64_t)header.frame_stride * (header.ft - 1) + header.frame_size;
+		return end <= file_size;
+	}
+
+	/**
+	 * @brief Write frames to a `.vcb` file.
+	 *
+	 * Fills the layout fields of @p header (magic, version, header_size, ft, frame_size,
+	 * frame_stride, data_offset); the caller sets the content fields.
+	 *
+	 * @param path Output file path.
+	 * @param header Header with width, height, loop, ratio, alpha, color12Bit and format set.
+	 * @param frames Frames in playback order (all the same size).
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : no frames, more than 65535 frames, frame sizes differ or do not match the header
+	 * - -2 : file open failed
+	 * - -3 : write failed
+	 */
+	inline int8_t write(const std::string& path, VcbHeader header, const std::vector<VFrameView>& frames)
+	{
+		if (frames.empty() || frames[0].empty() || frames.size() > 0xffff)
+			return -1;
+
+		const uint32_t frame_size = (uint32_t)frames[0].size;
+		for (const auto& frame : frames)
+		{
+			if (frame.size != frame_size)
+				return -1;
+		}
+
+		memcpy(header.magic, "VCB1", 4);
+		header.version = VCB_VERSION;
+		header.header_size = sizeof(VcbHeader);
+		header.ft = (uint16_t)frames.size();
+		header.frame_size = frame_size;
+		header.frame_stride = alignedSize(frame_size);
+		header.data_offset = alignedSize(sizeof(VcbHeader));
+		if (!isValid(header, UINT64_MAX))
+			return -1;
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return -2;
+
+		static const uint8_t padding[VCB_ALIGN] = {};
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = ok && fwrite(padding, 1, header.data_offset - sizeof(header), file) == header.data_offset - sizeof(header);
+		for (const auto& frame : frames)
+		{
+			if (!ok)
+				break;
+			ok = fwrite(frame.data, 1, frame_size, file) == frame_size;
+			ok = ok && fwrite(padding, 1, header.frame_stride - frame_size, file) == header.frame_stride - frame_size;
+		}
+
+		if (fclose(file) != 0)
+			ok = false;
+
+		return ok ? 0 : -3;
+	}
+
+	/**
+	 * @brief Write loaded content to a `.vcb` file.
+	 *
+	 * @param content Loaded content (all frames must have the same size).
+	 * @param path Output file path.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : content is not loaded, has more than 65535 frames or frames are inconsistent
+	 * - -2 : file open failed
+	 * - -3 : write failed
+	 */
+	inline int8_t save(const VContent& content, const std::string& path)
+	{
+		if (content.frames.size() > 0xffff)
+			return -1;
+
+		VcbHeader header{};
+		header.width = content.width;
+		header.height = content.height;
+		header.loop = content.loop;
+		header.ratio = content.ratio;
+		header.alpha = content.alpha ? 1 : 0;
+		header.color12Bit = content.color12Bit ? 1 : 0;
+		header.format = (uint8_t)(content.alpha ? VcbFormat::RGBA8888 : VcbFormat::RGB888);
+
+		std::vector<VFrameView> frames;
+		frames.reserve(content.frames.size());
+		for (uint16_t i = 0; i < content.frames.size(); i++)
+			frames.push_back(content.frameView(i));
+
+		return write(path, header, frames);
+	}
+};
+
+/**
+ * @brief Read-only, memory-mapped `.vcb` content.
+ *
+ * Frames are exposed as VFrameView pointing directly into the mapping; nothing is
+ * decoded or copied. The mapping is released when the object is destroyed.
+ *
+ * @note APIs that take a VContent* (e.g. EyeControl) need an owning copy; use toVContent().
+ */
+class VContentMap
+{
+public:
+	VContentMap() = default;
+	~VContentMap() { close(); }
+
+	VContentMap(const VContentMap&) = delete;
+	VContentMap& operator=(const VContentMap&) = delete;
+
+	VContentMap(VContentMap&& other) noexcept { *this = std::move(other); }
+
+	VContentMap& operator=(VContentMap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			path = std::move(other.path);
+			base = other.base;
+			length = other.length;
+			other.base = nullptr;
+			other.length = 0;
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief Map a `.vcb` file.
+	 *
+	 * @param file_path Path to the `.vcb` file.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : file open or stat failed
+	 * - -2 : mmap failed
+	 * - -3 : invalid or truncated container
+	 */
+	int8_t open(const std::string& file_path)
+	{
+		close();
+
+		int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			return -1;
+		}
+
+		if ((uint64_t)st.st_size < sizeof(VcbHeader))
+		{
+			::close(fd);
+			return -3;
+		}
+
+		void* mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mem == MAP_FAILED)
+			return -2;
+
+		if (!VContentFile::isValid(*static_cast<const VcbHeader*>(mem), (uint64_t)st.st_size))
+		{
+			munmap(mem, (size_t)st.st_size);
+			return -3;
+		}
+
+		// start paging in asynchronously; open() itself stays O(1)
+		madvise(mem, (size_t)st.st_size, MADV_WILLNEED);
+
+		base = static_cast<uint8_t*>(mem);
+		length = (size_t)st.st_size;
+		path = file_path;
+		return 0;
+	}
+
+	/**
+	 * @brief Release the mapping. Views returned by frame() become invalid.
+	 */
+	void close()
+	{
+		if (base != nullptr)
+			munmap(base, length);
+		base = nullptr;
+		length = 0;
+	}
+
+	/**
+	 * @brief Check whether a container is mapped.
+	 * @return true if open() succeeded; false otherwise.
+	 */
+	bool isReady() const { return base != nullptr; }
+
+	/**
+	 * @brief Container header (width, height, ft, ratio, loop, alpha, color12Bit, ...).
+	 * @warning Only valid if isReady() is true.
+	 */
+	const VcbHeader& header() const { return *reinterpret_cast<const VcbHeader*>(base); }
+
+	/**
+	 * @brief Get a frame without copying.
+	 *
+	 * @param index Frame index (0..ft-1).
+	 *
+	 * @return View into the mapping; empty if not ready or @p index is out of range.
+	 */
+	VFrameView frame(uint16_t index) const
+	{
+		if (base == nullptr || index >= header().ft)
+			return {};
+
+		const VcbHeader& h = header();
+		return { base + h.data_offset + (size_t)h.frame_stride * index, h.frame_size };
+	}
+
+	/**
+	 * @brief Build an owning VContent copy of the mapped frames.
+	 *
+	 * @return Loaded VContent; not ready if nothing is mapped or the frames are stored
+	 * in an LCD buffer format (VcbFormat::LCD12, VcbFormat::LCD18).
+	 */
+	VContent toVContent() const
+	{
+		VContent content;
+		if (base == nullptr || header().format > (uint8_t)VcbFormat::RGBA8888)
+			return content;
+
+		const VcbHeader& h = header();
+		content.frames.resize(h.ft);
+		for (uint16_t i = 0; i < h.ft; i++)
+		{
+			VFrameView view = frame(i);
+			content.frames[i].assign(view.begin(), view.end());
+		}
+
+		content.ft = h.ft;
+		content.width = h.width;
+		content.height = h.height;
+		content.path = path;
+		content.alpha = h.alpha != 0;
+		content.color12Bit = h.color12Bit != 0;
+		content.ratio = h.ratio;
+		content.loop = h.loop;
+		VContentAccess::setLoaded(content, true);
+		return content;
+	}
+
+	/** @brief Source path of the mapped file. */
+	std::string path;
+
+private:
+	uint8_t* base = nullptr;
+	size_t length = 0;
+};
+
+inline VContentMap VContent::map(const std::string& path)
+{
+	VContentMap content;
+	content.open(path);
+	return content;
+}
@@ -0,0 +1,244 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "QoiCodec.h"
+#include "VContent.h"
+#include "VFrameStore.h"
+
+/**
+ * @file VContentPack.h
+ * @brief Compressed in-memory VContent with on-demand frame decompression.
+ *
+ * Long RGBA animations cost 240*240*4 bytes per frame as raw VContent. VContentPack
+ * keeps every frame QOI-compressed (see QoiCodec.h) in one blob and decodes frame N
+ * just before it is displayed, into a small ring of decoded frames.
+ *
+ * Design notes:
+ * - Lossless; decoded frames are byte-identical to the source VContent frames
+ * - Ring slots live in one VFrameStore arena; a decoded frame stays cached until its
+ *   slot is reused, so repeated access (loops, both eyes) decodes only once
+ * - compressionRatio() and the decode timing getters report the actual cost on the device
+ *
+ * Threading notes:
+ * - Not thread-safe; use one instance per playback thread
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/**
+ * @brief Frame sequence kept compressed in memory.
+ */
+class VContentPack
+{
+public:
+	/**
+	 * @brief Compress a loaded VContent.
+	 *
+	 * @param content Loaded RGB or RGBA content.
+	 * @param ring_size Number of decoded frames kept (minimum 1).
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : content empty or frame sizes do not match width/height
+	 * - -2 : allocation failed
+	 */
+	int8_t assign(const VContent& content, uint8_t ring_size = 2)
+	{
+		const uint8_t ch = content.alpha ? 4 : 3;
+		const size_t pixels = (size_t)content.width * content.height;
+		if (content.frames.empty() || pixels == 0)
+			return -1;
+
+		for (const auto& frame : content.frames)
+		{
+			if (frame.size() != pixels * ch)
+				return -1;
+		}
+
+		blob.clear();
+		offsets.assign(1, 0);
+		for (const auto& frame : content.frames)
+		{
+			QoiCodec::encode(frame.data(), pixels, ch, blob);
+			offsets.push_back(blob.size());
+		}
+		blob.shrink_to_fit();
+
+		channels = ch;
+		ft = (uint16_t)content.frames.size();
+		width = content.width;
+		height = content.height;
+		alpha = content.alpha;
+		color12Bit = content.color12Bit;
+		ratio = content.ratio;
+		loop = content.loop;
+		path = content.path;
+
+		decode_count = 0;
+		decode_total_us = 0;
+		last_decode_us = 0;
+		return setRingSize(ring_size);
+	}
+
+	/**
+	 * @brief Change the number of decoded frames kept.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -2 : allocation failed
+	 */
+	int8_t setRingSize(uint8_t ring_size)
+	{
+		if (ring_size == 0)
+			ring_size = 1;
+
+		slot_frame.assign(ring_size, -1);
+		next_slot = 0;
+		if (ft == 0)
+			return 0;
+		return ring.reset(ring_size, rawFrameSize()) == 0 ? 0 : -2;
+	}
+
+	/**
+	 * @brief Get a decoded frame, decompressing it if it is not in the ring.
+	 *
+	 * @param index Frame index.
+	 *
+	 * @return View into the ring; valid until ring_size other frames were requested.
+	 *         Empty if @p index is out of range or the data is corrupt.
+	 */
+	VFrameView frame(uint16_t index)
+	{
+		if (index >= ft)
+			return {};
+
+		for (size_t s = 0; s < slot_frame.size(); s++)
+		{
+			if (slot_frame[s] == index)
+				return ring.frame((uint16_t)s);
+		}
+
+		uint16_t slot = next_slot;
+		next_slot = (uint16_t)((next_slot + 1) % slot_frame.size());
+		slot_frame[slot] = -1;
+		if (decode(index, ring.data(slot)) != 0)
+			return {};
+
+		slot_frame[slot] = index;
+		return ring.frame(slot);
+	}
+
+	/**
+	 * @brief Decode a frame into a caller-provided buffer.
+	 *
+	 * @param index Frame index.
+	 * @param output Output buffer, at least rawFrameSize() bytes.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : index out of range
+	 * - -2 : corrupt data
+	 */
+	int8_t decode(uint16_t index, uint8_t* output)
+	{
+		if (index >= ft)
+			return -1;
+
+		auto t0 = std::chrono::steady_clock::now();
+		bool ok = QoiCodec::decode(blob.data() + offsets[index], offsets[index + 1] - offsets[index],
+			output, (size_t)width * height, channels);
+		auto t1 = std::chrono::steady_clock::now();
+
+		last_decode_us = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+		decode_total_us += last_decode_us;
+		decode_count++;
+		return ok ? 0 : -2;
+	}
+
+	/**
+	 * @brief Decode all frames into an owning VContent.
+	 */
+	VContent toVContent()
+	{
+		VContent content;
+		content.frames.resize(ft);
+		for (uint16_t i = 0; i < ft; i++)
+		{
+			content.frames[i].resize(rawFrameSize());
+			if (decode(i, content.frames[i].data()) != 0)
+				return VContent();
+		}
+
+		content.ft = ft;
+		content.width = width;
+		content.height = height;
+		content.path = path;
+		content.alpha = alpha;
+		content.color12Bit = color12Bit;
+		content.ratio = ratio;
+		content.loop = loop;
+		VContentAccess::setLoaded(content, ft != 0);
+		return content;
+	}
+
+	/** @brief Size of one decoded frame in bytes. */
+	size_t rawFrameSize() const { return (size_t)width * height * channels; }
+
+	/** @brief Total compressed size in bytes. */
+	size_t compressedBytes() const { return blob.size(); }
+
+	/** @brief Total decoded size of all frames in bytes. */
+	size_t rawBytes() const { return rawFrameSize() * ft; }
+
+	/** @brief Raw size divided by compressed size (0 if empty). */
+	float compressionRatio() const { return blob.empty() ? 0.0f : (float)rawBytes() / (float)blob.size(); }
+
+	/** @brief Duration of the last frame decode in microseconds. */
+	uint32_t lastDecodeUs() const { return last_decode_us; }
+
+	/** @brief Average frame decode duration in microseconds (0 if nothing decoded yet). */
+	uint32_t averageDecodeUs() const { return decode_count == 0 ? 0 : (uint32_t)(decode_total_us / decode_count); }
+
+	/** @brief True if frames are loaded. */
+	bool isReady() const { return ft != 0; }
+
+	/** @brief Total number of frames. */
+	uint16_t ft = 0;
+
+	/** @brief Frame width in pixels. */
+	uint16_t width = 0;
+
+	/** @brief Frame height in pixels. */
+	uint16_t height = 0;
+
+	/** @brief True if frames have an alpha channel. */
+	bool alpha = false;
+
+	/** @brief True if frames are quantized to 12-bit color. */
+	bool color12Bit = false;
+
+	/** @brief Frame rate divider (see VContent::ratio). */
+	uint8_t ratio = 1;
+
+	/** @brief Loop count (see VContent::loop). */
+	uint16_t loop = 0;
+
+	/** @brief Source path. */
+	std::string path;
+
+private:
+	std::vector<uint8_t> blob;
+	// frame N is blob[offsets[N] .. offsets[N + 1])
+	std::vector<size_t> offsets;
+	uint8_t channels = 3;
+
+	VFrameStore ring;
+	std::vector<int32_t> slot_frame;
+	uint16_t next_slot = 0;
+
+	uint32_t last_decode_us = 0;
+	uint64_t decode_total_us = 0;
+	uint32_t decode_count = 0;
+};
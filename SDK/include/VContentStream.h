@@ -0,0 +1,293 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "VContentMap.h"
+#include "VFrameStore.h"
+
+/**
+ * @file VContentStream.h
+ * @brief Streaming `.vcb` playback from disk with bounded read-ahead.
+ *
+ * For long clips (intros, idle loops) the whole sequence does not need to be in RAM.
+ * VContentStream reads frames of a `.vcb` file (see VContentMap.h) on a background
+ * I/O thread into a ring of `depth` frame slots, ahead of the frame the consumer
+ * asked for last. Memory use is depth * frame size regardless of the clip length.
+ *
+ * Design notes:
+ * - The consumer pulls frames by index with read(); the returned view stays valid
+ *   until the next read() call
+ * - The I/O thread keeps frames [index, index + depth - 1] loaded (wrapping when looping)
+ *   and hints the kernel with posix_fadvise() so the next window is read ahead
+ * - Works with every VcbFormat; LCD formats can go straight to VLcdContent::write()
+ *
+ * Threading notes:
+ * - read() must be called from a single consumer thread
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/**
+ * @brief Frame source that streams a `.vcb` file through a bounded ring.
+ */
+class VContentStream
+{
+public:
+	VContentStream() = default;
+	~VContentStream() { close(); }
+
+	VContentStream(const VContentStream&) = delete;
+	VContentStream& operator=(const VContentStream&) = delete;
+
+	/**
+	 * @brief Open a `.vcb` file and start the I/O thread.
+	 *
+	 * @param file_path Path to the `.vcb` file.
+	 * @param depth Number of frame slots in the ring (minimum 2).
+	 * @param looping If true, read-ahead wraps from the last frame to frame 0.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : file open or read failed
+	 * - -2 : invalid or truncated container
+	 * - -3 : allocation failed
+	 */
+	int8_t open(const std::string& file_path, uint8_t depth = 4, bool looping = true)
+	{
+		close();
+
+		fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || pread(fd, &vcb, sizeof(vcb), 0) != (ssize_t)sizeof(vcb))
+		{
+			close();
+			return -1;
+		}
+
+		if (!VContentFile::isValid(vcb, (uint64_t)st.st_size))
+		{
+			close();
+			return -2;
+		}
+
+		if (depth < 2)
+			depth = 2;
+
+		if (store.reset(depth, vcb.frame_size) != 0)
+		{
+			close();
+			return -3;
+		}
+
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+		slots.assign(depth, Slot());
+		loop = looping;
+		wanted = 0;
+		pinned = -1;
+		failed_index = -1;
+		stall_count = 0;
+		path = file_path;
+		running = true;
+		io_thread = std::thread([this] { ioThreadFunc(); });
+		return 0;
+	}
+
+	/**
+	 * @brief Stop the I/O thread and close the file.
+	 */
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			running = false;
+		}
+		cond.notify_all();
+		if (io_thread.joinable())
+			io_thread.join();
+
+		// a failure of this file must not end waits on the next one
+		failed_index = -1;
+		pinned = -1;
+
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+	}
+
+	/**
+	 * @brief Get a frame, waiting for the I/O thread if it is not loaded yet.
+	 *
+	 * Also moves the read-ahead window to start at @p index.
+	 *
+	 * @param index Frame index (0..ft-1).
+	 * @param timeout_ms Maximum wait in milliseconds.
+	 *
+	 * @return View into the ring, valid until the next read(); empty on timeout,
+	 *         read error or out-of-range @p index.
+	 */
+	VFrameView read(uint16_t index, unsigned int timeout_ms = 100)
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		if (!running || index >= vcb.ft)
+			return {};
+
+		pinned = -1;
+		wanted = index;
+		cond.notify_all();
+
+		int slot = findSlot(index, true);
+		if (slot < 0)
+		{
+			stall_count++;
+			cond.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] {
+				slot = findSlot(index, true);
+				return slot >= 0 || !running || failed_index == index;
+			});
+		}
+
+		if (slot < 0)
+			return {};
+
+		pinned = slot;
+		return store.frame((uint16_t)slot);
+	}
+
+	/**
+	 * @brief Container header of the open file.
+	 * @warning Only valid if isReady() is true.
+	 */
+	const VcbHeader& header() const { return vcb; }
+
+	/** @brief True if a file is open and streaming. */
+	bool isReady() const { return fd >= 0; }
+
+	/** @brief Number of read() calls that had to wait for the disk (any thread may poll it). */
+	uint32_t stallCount() const { return stall_count.load(std::memory_order_relaxed); }
+
+	/** @brief Ring memory in bytes (constant for the lifetime of the stream). */
+	size_t ringBytes() const { return store.stride() * store.frameCount(); }
+
+	/** @brief Source path. */
+	std::string path;
+
+private:
+	struct Slot
+	{
+		int32_t index = -1;
+		bool ready = false;
+	};
+
+	int findSlot(int32_t index, bool ready_only) const
+	{
+		for (size_t s = 0; s < slots.size(); s++)
+		{
+			if (slots[s].index == index && (!ready_only || slots[s].ready))
+				return (int)s;
+		}
+		return -1;
+	}
+
+	// frame at position k of the current read-ahead window, -1 past the end
+	int32_t windowFrame(size_t k) const
+	{
+		int32_t index = (int32_t)wanted + (int32_t)k;
+		if (index < vcb.ft)
+			return index;
+		return loop ? index % vcb.ft : -1;
+	}
+
+	bool inWindow(int32_t index) const
+	{
+		for (size_t k = 0; k < slots.size(); k++)
+		{
+			if (windowFrame(k) == index)
+				return true;
+		}
+		return false;
+	}
+
+	void ioThreadFunc()
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		while (running)
+		{
+			// nearest frame of the window that is not loaded yet
+			int32_t next = -1;
+			for (size_t k = 0; k < slots.size() && next < 0; k++)
+			{
+				int32_t index = windowFrame(k);
+				if (index >= 0 && findSlot(index, false) < 0)
+					next = index;
+			}
+
+			int victim = -1;
+			for (size_t s = 0; s < slots.size() && next >= 0 && victim < 0; s++)
+			{
+				if ((int)s != pinned && (slots[s].index < 0 || !inWindow(slots[s].index)))
+					victim = (int)s;
+			}
+
+			if (next < 0 || victim < 0)
+			{
+				cond.wait(lk);
+				continue;
+			}
+
+			slots[victim].index = next;
+			slots[victim].ready = false;
+			uint16_t request = wanted;
+			lk.unlock();
+
+			off_t offset = (off_t)vcb.data_offset + (off_t)vcb.frame_stride * next;
+			ssize_t got = pread(fd, store.data((uint16_t)victim), vcb.frame_size, offset);
+
+			// hint the kernel about the frames after the current window
+			off_t ahead = offset + (off_t)vcb.frame_stride;
+			posix_fadvise(fd, ahead, (off_t)vcb.frame_stride * slots.size(), POSIX_FADV_WILLNEED);
+
+			lk.lock();
+			if (got == (ssize_t)vcb.frame_size)
+			{
+				slots[victim].ready = true;
+				if (failed_index == next)
+					failed_index = -1;
+			}
+			else
+			{
+				slots[victim].index = -1;
+				failed_index = next;
+				// do not retry in a tight loop, wait for the consumer to move on
+				if (wanted == request)
+					cond.wait_for(lk, std::chrono::milliseconds(10));
+			}
+			cond.notify_all();
+		}
+	}
+
+	int fd = -1;
+	VcbHeader vcb{};
+	VFrameStore store;
+	std::vector<Slot> slots;
+	bool loop = true;
+
+	std::thread io_thread;
+	std::mutex mtx;
+	std::condition_variable cond;
+	bool running = false;
+	uint16_t wanted = 0;
+	int pinned = -1;
+	int32_t failed_index = -1;
+	std::atomic<uint32_t> stall_count{ 0 };
+};
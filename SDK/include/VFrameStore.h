@@ -0,0 +1,228 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include "VContent.h"
+
+/**
+ * @file VFrameStore.h
+ * @brief Contiguous, single-allocation frame storage for VContent data.
+ *
+ * VContent::frames keeps one heap allocation per frame. VFrameStore keeps all frames
+ * of a sequence in one arena with a fixed, cache-line aligned frame stride and hands
+ * them out as VFrameView. It backs the SDK helpers that work on raw frames
+ * (VContentPack, VLcdContent, VContentStream).
+ *
+ * Design notes:
+ * - One allocation, VFRAME_ALIGN aligned; frame N starts at N * stride()
+ * - Same stride/alignment rules as the `.vcb` container (see VContentMap.h)
+ * - VContent and EyeControl playback keep their per-frame vectors; toVContent() makes
+ *   that copy for APIs that take VContent*
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/** @brief Alignment of every frame in a VFrameStore, in bytes. */
+constexpr size_t VFRAME_ALIGN = 64;
+
+/**
+ * @brief Frame sequence stored in one aligned arena.
+ */
+class VFrameStore
+{
+public:
+	VFrameStore() = default;
+	~VFrameStore() = default;
+
+	VFrameStore(const VFrameStore&) = delete;
+	VFrameStore& operator=(const VFrameStore&) = delete;
+	VFrameStore(VFrameStore&& other) noexcept { *this = std::move(other); }
+
+	VFrameStore& operator=(VFrameStore&& other) noexcept
+	{
+		if (this != &other)
+		{
+			arena = std::move(other.arena);
+			capacity = other.capacity;
+			frame_size = other.frame_size;
+			frame_stride = other.frame_stride;
+			ft = other.ft;
+			width = other.width;
+			height = other.height;
+			alpha = other.alpha;
+			color12Bit = other.color12Bit;
+			ratio = other.ratio;
+			loop = other.loop;
+			path = std::move(other.path);
+			other.capacity = other.frame_size = other.frame_stride = 0;
+			other.ft = 0;
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief Allocate storage for a sequence. Existing frames are discarded.
+	 *
+	 * The arena is reused without reallocation if it is already large enough.
+	 *
+	 * @param frame_count Number of frames.
+	 * @param bytes_per_frame Size of one frame in bytes.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : invalid size
+	 * - -2 : allocation failed
+	 */
+	int8_t reset(uint16_t frame_count, size_t bytes_per_frame)
+	{
+		if (frame_count == 0 || bytes_per_frame == 0)
+			return -1;
+
+		size_t new_stride = (bytes_per_frame + VFRAME_ALIGN - 1) & ~(VFRAME_ALIGN - 1);
+		size_t required = new_stride * frame_count;
+		if (required > capacity)
+		{
+			uint8_t* mem = static_cast<uint8_t*>(std::aligned_alloc(VFRAME_ALIGN, required));
+			if (mem == nullptr)
+				return -2;
+			arena.reset(mem);
+			capacity = required;
+		}
+
+		ft = frame_count;
+		frame_size = bytes_per_frame;
+		frame_stride = new_stride;
+		return 0;
+	}
+
+	/**
+	 * @brief Copy a loaded VContent into the arena.
+	 *
+	 * @param content Loaded content (all frames must have the same size).
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : content is empty or frame sizes differ
+	 * - -2 : allocation failed
+	 */
+	int8_t assign(const VContent& content)
+	{
+		if (content.frames.empty() || content.frames[0].empty())
+			return -1;
+
+		for (const auto& frame : content.frames)
+		{
+			if (frame.size() != content.frames[0].size())
+				return -1;
+		}
+
+		int8_t ret = reset((uint16_t)content.frames.size(), content.frames[0].size());
+		if (ret != 0)
+			return ret;
+
+		for (uint16_t i = 0; i < ft; i++)
+			memcpy(data(i), content.frames[i].data(), frame_size);
+
+		width = content.width;
+		height = content.height;
+		alpha = content.alpha;
+		color12Bit = content.color12Bit;
+		ratio = content.ratio;
+		loop = content.loop;
+		path = content.path;
+		return 0;
+	}
+
+	/**
+	 * @brief Build an owning VContent copy (one vector per frame).
+	 */
+	VContent toVContent() const
+	{
+		VContent content;
+		if (ft == 0)
+			return content;
+
+		content.frames.resize(ft);
+		for (uint16_t i = 0; i < ft; i++)
+		{
+			VFrameView view = frame(i);
+			content.frames[i].assign(view.begin(), view.end());
+		}
+
+		content.ft = ft;
+		content.width = width;
+		content.height = height;
+		content.path = path;
+		content.alpha = alpha;
+		content.color12Bit = color12Bit;
+		content.ratio = ratio;
+		content.loop = loop;
+		VContentAccess::setLoaded(content, true);
+		return content;
+	}
+
+	/**
+	 * @brief Read-only view of a frame.
+	 * @return View into the arena; empty if @p index is out of range.
+	 */
+	VFrameView frame(uint16_t index) const
+	{
+		if (index >= ft)
+			return {};
+		return { arena.get() + frame_stride * index, frame_size };
+	}
+
+	/**
+	 * @brief Writable pointer to a frame (VFRAME_ALIGN aligned).
+	 * @warning @p index must be less than frameCount().
+	 */
+	uint8_t* data(uint16_t index) { return arena.get() + frame_stride * index; }
+
+	/** @brief Number of frames. */
+	uint16_t frameCount() const { return ft; }
+
+	/** @brief Size of one frame in bytes. */
+	size_t frameSize() const { return frame_size; }
+
+	/** @brief Distance between two frames in bytes. */
+	size_t stride() const { return frame_stride; }
+
+	/** @brief True if storage holds at least one frame. */
+	bool isReady() const { return ft != 0; }
+
+	/** @brief Frame width in pixels. */
+	uint16_t width = 0;
+
+	/** @brief Frame height in pixels. */
+	uint16_t height = 0;
+
+	/** @brief True if frames have an alpha channel. */
+	bool alpha = false;
+
+	/** @brief True if frames are quantized to 12-bit color. */
+	bool color12Bit = false;
+
+	/** @brief Frame rate divider (see VContent::ratio). */
+	uint8_t ratio = 1;
+
+	/** @brief Loop count (see VContent::loop). */
+	uint16_t loop = 0;
+
+	/** @brief Source path. */
+	std::string path;
+
+private:
+	struct FreeDeleter
+	{
+		void operator()(uint8_t* p) const { std::free(p); }
+	};
+
+	std::unique_ptr<uint8_t, FreeDeleter> arena;
+	size_t capacity = 0;
+	size_t frame_size = 0;
+	size_t frame_stride = 0;
+	uint16_t ft = 0;
+};
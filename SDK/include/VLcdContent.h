@@ -0,0 +1,245 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LcdControl.h"
+#include "VContent.h"
+#include "VContentMap.h"
+#include "VFrameStore.h"
+
+/**
+ * @file VLcdContent.h
+ * @brief VContent frames stored pre-converted in the LcdControl buffer format.
+ *
+ * VContent keeps 8 bits per channel even for 12-bit content, so every displayed frame
+ * goes through LcdControl::toLcdBuffer(). VLcdContent runs that conversion once at load
+ * and keeps frames in the exact panel format, so full-screen content (backgrounds,
+ * video clips) goes straight to LcdControl::writeLcd().
+ *
+ * Design notes:
+ * - Requires LcdControl::init(); frames use the depth configured at conversion time
+ * - Content must be full-panel sized (one LCD buffer per frame)
+ * - 12-bit frames take 1.5 bytes per pixel (50% of RGB888)
+ * - Optional separate alpha plane (1 byte per pixel) for compositing RGBA content
+ * - Frames live in one VFrameStore arena and can be saved as a `.vcb` file
+ *   (VcbFormat::LCD12 / VcbFormat::LCD18) for zero-conversion loading via VContent::map()
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/**
+ * @brief Frame sequence stored in LcdControl buffer format.
+ */
+class VLcdContent
+{
+public:
+	/**
+	 * @brief Convert loaded content to the current LCD buffer format.
+	 *
+	 * @param content Loaded RGB or RGBA content, full-panel sized.
+	 * @param keepAlpha If true and @p content has alpha, keep a separate alpha plane.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : LcdControl not active
+	 * - -2 : content empty or not full-panel sized
+	 * - -3 : allocation failed
+	 */
+	int8_t assign(const VContent& content, bool keepAlpha = false)
+	{
+		if (!LcdControl::isActive())
+			return -1;
+
+		const size_t channels = content.alpha ? 4 : 3;
+		const size_t pixels = (size_t)content.width * content.height;
+		const size_t buffer_size = (size_t)LcdControl::getBufferSize();
+		const LcdColorDepth lcd_depth = LcdControl::getColorDepth();
+		const size_t panel_pixels = lcd_depth == LcdColorDepth::L12BIT ? buffer_size * 2 / 3 : buffer_size / 3;
+
+		if (content.frames.empty() || pixels != panel_pixels)
+			return -2;
+
+		for (const auto& frame : content.frames)
+		{
+			if (frame.size() != pixels * channels)
+				return -2;
+		}
+
+		const uint16_t count = (uint16_t)content.frames.size();
+		if (store.reset(count, buffer_size) != 0)
+			return -3;
+
+		const bool with_alpha = keepAlpha && content.alpha;
+		if (with_alpha && alpha_store.reset(count, pixels) != 0)
+			return -3;
+
+		for (uint16_t i = 0; i < count; i++)
+		{
+			LcdControl::toLcdBuffer(store.data(i), const_cast<uint8_t*>(content.frames[i].data()), content.alpha);
+
+			if (with_alpha)
+			{
+				const uint8_t* src = content.frames[i].data() + 3;
+				uint8_t* dst = alpha_store.data(i);
+				for (size_t p = 0; p < pixels; p++, src += 4)
+					dst[p] = *src;
+			}
+		}
+
+		if (!with_alpha)
+			alpha_store = VFrameStore();
+
+		depth = lcd_depth;
+		width = content.width;
+		height = content.height;
+		ratio = content.ratio;
+		loop = content.loop;
+		path = content.path;
+		return 0;
+	}
+
+	/**
+	 * @brief Copy LCD-format frames from a mapped `.vcb` file.
+	 *
+	 * For playback without any copy, write the mapped frames directly with
+	 * write(LcdSide, VFrameView) instead.
+	 *
+	 * @param mapped Mapped container with format VcbFormat::LCD12 or VcbFormat::LCD18.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -2 : not mapped or not an LCD format
+	 * - -3 : allocation failed
+	 */
+	int8_t assign(const VContentMap& mapped)
+	{
+		if (!mapped.isReady())
+			return -2;
+
+		const VcbHeader& h = mapped.header();
+		if (h.format != (uint8_t)VcbFormat::LCD12 && h.format != (uint8_t)VcbFormat::LCD18)
+			return -2;
+
+		if (store.reset(h.ft, h.frame_size) != 0)
+			return -3;
+
+		for (uint16_t i = 0; i < h.ft; i++)
+		{
+			VFrameView view = mapped.frame(i);
+			memcpy(store.data(i), view.data, view.size);
+		}
+
+		alpha_store = VFrameStore();
+		depth = h.format == (uint8_t)VcbFormat::LCD12 ? LcdColorDepth::L12BIT : LcdColorDepth::L18BIT;
+		width = h.width;
+		height = h.height;
+		ratio = h.ratio;
+		loop = h.loop;
+		path = mapped.path;
+		return 0;
+	}
+
+	/**
+	 * @brief Write a frame to a panel without any conversion.
+	 *
+	 * @param side Target LCD side.
+	 * @param index Frame index.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : ioctl error
+	 * - -2 : not active (init() not called or failed)
+	 * - -3 : frame index out of range or depth differs from the current LCD depth
+	 */
+	int8_t write(LcdSide side, uint16_t index)
+	{
+		if (index >= store.frameCount())
+			return -3;
+		return write(side, store.frame(index), depth);
+	}
+
+	/**
+	 * @brief Write an LCD-format frame from any source (e.g. a mapped `.vcb` file).
+	 *
+	 * @param side Target LCD side.
+	 * @param frame Frame in LCD buffer format.
+	 * @param frame_depth Depth the frame was converted with.
+	 *
+	 * @return Status code:
+	 * - 0  : success
+	 * - -1 : ioctl error
+	 * - -2 : not active (init() not called or failed)
+	 * - -3 : frame size or depth does not match the current LCD configuration
+	 */
+	static int8_t write(LcdSide side, VFrameView frame, LcdColorDepth frame_depth)
+	{
+		if (!LcdControl::isActive())
+			return -2;
+
+		if (frame_depth != LcdControl::getColorDepth() || frame.size != (size_t)LcdControl::getBufferSize())
+			return -3;
+
+		// writeLcd only reads the buffer
+		LcdData data{ side, const_cast<uint8_t*>(frame.data) };
+		return LcdControl::writeLcd(&data);
+	}
+
+	/**
+	 * @brief Save frames as a `.vcb` file (VcbFormat::LCD12 or VcbFormat::LCD18).
+	 *
+	 * The alpha plane is not stored.
+	 *
+	 * @return Status code (see VContentFile::write()).
+	 */
+	int8_t save(const std::string& file_path) const
+	{
+		VcbHeader header{};
+		header.width = width;
+		header.height = height;
+		header.loop = loop;
+		header.ratio = ratio;
+		header.color12Bit = depth == LcdColorDepth::L12BIT ? 1 : 0;
+		header.format = (uint8_t)(depth == LcdColorDepth::L12BIT ? VcbFormat::LCD12 : VcbFormat::LCD18);
+
+		std::vector<VFrameView> frames;
+		for (uint16_t i = 0; i < store.frameCount(); i++)
+			frames.push_back(store.frame(i));
+
+		return VContentFile::write(file_path, header, frames);
+	}
+
+	/** @brief Frame in LCD buffer format; empty if out of range. */
+	VFrameView frame(uint16_t index) const { return store.frame(index); }
+
+	/** @brief Alpha plane of a frame (1 byte per pixel); empty if not kept. */
+	VFrameView alphaPlane(uint16_t index) const { return alpha_store.frame(index); }
+
+	/** @brief Number of frames. */
+	uint16_t frameCount() const { return store.frameCount(); }
+
+	/** @brief True if frames are loaded. */
+	bool isReady() const { return store.isReady(); }
+
+	/** @brief LCD depth the frames were converted with. */
+	LcdColorDepth depth = LcdColorDepth::L12BIT;
+
+	/** @brief Frame width in pixels. */
+	uint16_t width = 0;
+
+	/** @brief Frame height in pixels. */
+	uint16_t height = 0;
+
+	/** @brief Frame rate divider (see VContent::ratio). */
+	uint8_t ratio = 1;
+
+	/** @brief Loop count (see VContent::loop). */
+	uint16_t loop = 0;
+
+	/** @brief Source path. */
+	std::string path;
+
+private:
+	VFrameStore store;
+	VFrameStore alpha_store;
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VPIXEL_NEON 1
+#else
+#define VPIXEL_NEON 0
+#endif
+
+/**
+ * @file VPixelKernels.h
+ * @brief Fused per-row pixel conversion used by the VContent decoders.
+ *
+ * Decoded rows are converted to the VContent frame layout in one pass:
+ * 16 -> 8 bit narrowing, channel expansion/removal, optional alpha premultiplication
+ * and optional 12-bit quantization all happen while the row is in registers, instead
+ * of one scalar pass over the whole frame per step.
+ *
+ * Design notes:
+ * - NEON (Raspberry Pi) processes 8 pixels per iteration, the tail and non-ARM builds
+ *   use the scalar path; both produce identical bytes
+ * - 16-bit samples are big-endian (PNG/Netpbm byte order) and narrowed to their high byte
+ * - Premultiplication uses the narrowed 8-bit alpha: c' = round(c * a / 255)
+ * - Quantization runs last and shifts each color channel right by 4 (0..15, the same
+ *   values VContent::getImage() stores for 12-bit content); alpha stays 8-bit
+ *
+ * @ingroup doly_common_vcontent
+ */
+
+/** @brief Multiply color channels by alpha (sources with 4 channels only). */
+constexpr uint8_t VPIXEL_PREMULTIPLY = 0x01;
+
+/** @brief Shift each color channel right by 4 bits (12-bit color); alpha is unchanged. */
+constexpr uint8_t VPIXEL_12BIT = 0x02;
+
+namespace VPixelKernels
+{
+	inline uint8_t premultiply(uint8_t c, uint8_t a)
+	{
+		uint32_t t = (uint32_t)c * a + 128;
+		return (uint8_t)((t + (t >> 8)) >> 8);
+	}
+
+	/**
+	 * @brief Portable reference implementation of convertRow().
+	 */
+	inline void convertRowScalar(const uint8_t* src, uint8_t src_channels, bool src_16bit,
+		uint8_t* dst, uint8_t dst_channels, size_t count, uint8_t flags)
+	{
+		const size_t step = src_16bit ? 2 : 1;
+		const bool premul = (flags & VPIXEL_PREMULTIPLY) && src_channels == 4;
+		const int shift = (flags & VPIXEL_12BIT) ? 4 : 0;
+		for (size_t i = 0; i < count; i++, src += src_channels * step, dst += dst_channels)
+		{
+			// the high byte of a big-endian 16-bit sample is its first byte
+			uint8_t r = src[0];
+			uint8_t g = src[step];
+			uint8_t b = src[2 * step];
+			uint8_t a = src_channels == 4 ? src[3 * step] : 255;
+			if (premul)
+			{
+				r = premultiply(r, a);
+				g = premultiply(g, a);
+				b = premultiply(b, a);
+			}
+
+			dst[0] = (uint8_t)(r >> shift);
+			dst[1] = (uint8_t)(g >> shift);
+			dst[2] = (uint8_t)(b >> shift);
+			if (dst_channels == 4)
+				dst[3] = a;
+		}
+	}
+
+#if VPIXEL_NEON
+	// round(c * a / 255) for 8 lanes, bit-exact with premultiply()
+	inline uint8x8_t premultiply8(uint8x8_t c, uint8x8_t a)
+	{
+		uint16x8_t x = vmull_u8(c, a);
+		x = vaddq_u16(x, vrshrq_n_u16(x, 8));
+		return vrshrn_n_u16(x, 8);
+	}
+
+	template <int SRC_CH, int DST_CH, bool SRC_16>
+	inline size_t convertRowNeon(const uint8_t* src, uint8_t* dst, size_t count, uint8_t flags)
+	{
+		const bool premul = SRC_CH == 4 && (flags & VPIXEL_PREMULTIPLY);
+		const bool quantize = (flags & VPIXEL_12BIT) != 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			uint8x8_t r, g, b, a = vdup_n_u8(255);
+			if (SRC_16)
+			{
+				// little-endian lanes: the low byte of each lane is the sample's high byte
+				const uint16_t* s = reinterpret_cast<const uint16_t*>(src + i * SRC_CH * 2);
+				if (SRC_CH == 4)
+				{
+					uint16x8x4_t v = vld4q_u16(s);
+					r = vmovn_u16(v.val[0]);
+					g = vmovn_u16(v.val[1]);
+					b = vmovn_u16(v.val[2]);
+					a = vmovn_u16(v.val[3]);
+				}
+				else
+				{
+					uint16x8x3_t v = vld3q_u16(s);
+					r = vmovn_u16(v.val[0]);
+					g = vmovn_u16(v.val[1]);
+					b = vmovn_u16(v.val[2]);
+				}
+			}
+			else
+			{
+				const uint8_t* s = src + i * SRC_CH;
+				if (SRC_CH == 4)
+				{
+					uint8x8x4_t v = vld4_u8(s);
+					r = v.val[0];
+					g = v.val[1];
+					b = v.val[2];
+					a = v.val[3];
+				}
+				else
+				{
+					uint8x8x3_t v = vld3_u8(s);
+					r = v.val[0];
+					g = v.val[1];
+					b = v.val[2];
+				}
+			}
+
+			if (premul)
+			{
+				r = premultiply8(r, a);
+				g = premultiply8(g, a);
+				b = premultiply8(b, a);
+			}
+
+			if (quantize)
+			{
+				r = vshr_n_u8(r, 4);
+				g = vshr_n_u8(g, 4);
+				b = vshr_n_u8(b, 4);
+			}
+
+			if (DST_CH == 4)
+			{
+				uint8x8x4_t out = { { r, g, b, a } };
+				vst4_u8(dst + i * 4, out);
+			}
+			else
+			{
+				uint8x8x3_t out = { { r, g, b } };
+				vst3_u8(dst + i * 3, out);
+			}
+		}
+		return i;
+	}
+#endif
+
+	/**
+	 * @brief Convert one row of pixels to the VContent frame layout.
+	 *
+	 * @p src and @p dst may be the same buffer if the source is 8-bit and
+	 * @p src_channels == @p dst_channels (in-place premultiply / quantize).
+	 *
+	 * @param src Source samples; 16-bit samples are big-endian.
+	 * @param src_channels 3 or 4.
+	 * @param src_16bit True if @p src holds 16-bit samples.
+	 * @param dst Output row (count * dst_channels bytes).
+	 * @param dst_channels 3 or 4; missing alpha is set to 255.
+	 * @param count Number of pixels.
+	 * @param flags VPIXEL_PREMULTIPLY and/or VPIXEL_12BIT.
+	 */
+	inline void convertRow(const uint8_t* src, uint8_t src_channels, bool src_16bit,
+		uint8_t* dst, uint8_t dst_channels, size_t count, uint8_t flags)
+	{
+		size_t done = 0;
+#if VPIXEL_NEON
+		const int key = (src_16bit ? 100 : 0) + src_channels * 10 + dst_channels;
+		switch (key)
+		{
+		case 44: done = convertRowNeon<4, 4, false>(src, dst, count, flags); break;
+		case 43: done = convertRowNeon<4, 3, false>(src, dst, count, flags); break;
+		case 34: done = convertRowNeon<3, 4, false>(src, dst, count, flags); break;
+		case 33: done = convertRowNeon<3, 3, false>(src, dst, count, flags); break;
+		case 144: done = convertRowNeon<4, 4, true>(src, dst, count, flags); break;
+		case 143: done = convertRowNeon<4, 3, true>(src, dst, count, flags); break;
+		case 134: done = convertRowNeon<3, 4, true>(src, dst, count, flags); break;
+		case 133: done = convertRowNeon<3, 3, true>(src, dst, count, flags); break;
+		default: break;
+		}
+#endif
+		const size_t src_pixel = (size_t)src_channels * (src_16bit ? 2 : 1);
+		convertRowScalar(src + done * src_pixel, src_channels, src_16bit,
+			dst + done * dst_channels, dst_channels, count - done, flags);
+	}
+};
@@ -0,0 +1,261 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUV_NEON 1
+#else
+#define YUV_NEON 0
+#endif
+
+/**
+ * @file YuvKernels.h
+ * @brief YUV420 (I420) <-> BGR and BGR -> luma conversion used by PiCameraStream.
+ *
+ * Converts camera frames between the packed BGR layout and planar YUV420 in one pass
+ * per row, straight from the mapped camera buffer into the destination, so no
+ * intermediate frame is needed.
+ *
+ * Design notes:
+ * - BT.601 limited range (Y 16..235), the convention of cv::COLOR_YUV2BGR_I420 and
+ *   cv::COLOR_BGR2YUV_I420; results may differ from OpenCV by 1
+ * - Grey frames are the luma (Y) plane, the same bytes a YUV420 stream delivers
+ * - Chroma of a 2x2 block is computed from the block's average color
+ * - NEON (Raspberry Pi) processes 8 or 16 pixels per iteration, the tail and non-ARM
+ *   builds use the scalar path; both produce identical bytes
+ * - Frame widths and heights passed to bgrToI420() must be even
+ *
+ * @ingroup doly_sdk_common
+ */
+
+namespace YuvKernels
+{
+	// Q13 YUV -> RGB coefficients
+	constexpr int16_t COEF_Y = 9539;	// 1.164
+	constexpr int16_t COEF_RV = 13074;	// 1.596
+	constexpr int16_t COEF_GU = 3209;	// 0.392
+	constexpr int16_t COEF_GV = 6660;	// 0.813
+	constexpr int16_t COEF_BU = 16525;	// 2.017
+
+	inline uint8_t clamp255(int32_t v)
+	{
+		return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+	}
+
+	/**
+	 * @brief Portable reference implementation of i420ToBgrRow().
+	 */
+	inline void i420ToBgrRowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgr, size_t count)
+	{
+		for (size_t i = 0; i < count; i++, bgr += 3)
+		{
+			const int32_t c = ((int32_t)y[i] - 16) * COEF_Y;
+			const int32_t d = (int32_t)u[i / 2] - 128;
+			const int32_t e = (int32_t)v[i / 2] - 128;
+			bgr[0] = clamp255((c + COEF_BU * d + 4096) >> 13);
+			bgr[1] = clamp255((c - COEF_GU * d - COEF_GV * e + 4096) >> 13);
+			bgr[2] = clamp255((c + COEF_RV * e + 4096) >> 13);
+		}
+	}
+
+	/**
+	 * @brief Portable reference implementation of bgrToGreyRow().
+	 */
+	inline void bgrToGreyRowScalar(const uint8_t* bgr, uint8_t* grey, size_t count)
+	{
+		for (size_t i = 0; i < count; i++, bgr += 3)
+			grey[i] = (uint8_t)(((25 * bgr[0] + 129 * bgr[1] + 66 * bgr[2] + 128) >> 8) + 16);
+	}
+
+	/**
+	 * @brief Portable reference implementation of bgrToUvRow().
+	 */
+	inline void bgrToUvRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v, size_t count)
+	{
+		for (size_t i = 0; i + 1 < count; i += 2, row0 += 6, row1 += 6)
+		{
+			const int32_t b = (row0[0] + row0[3] + row1[0] + row1[3] + 2) >> 2;
+			const int32_t g = (row0[1] + row0[4] + row1[1] + row1[4] + 2) >> 2;
+			const int32_t r = (row0[2] + row0[5] + row1[2] + row1[5] + 2) >> 2;
+			u[i / 2] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			v[i / 2] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+	}
+
+#if YUV_NEON
+	// one channel of 8 pixels: saturate(round(x / 2^13)) from two int32x4 halves
+	inline uint8x8_t narrowQ13(int32x4_t lo, int32x4_t hi)
+	{
+		return vqmovn_u16(vcombine_u16(vqrshrun_n_s32(lo, 13), vqrshrun_n_s32(hi, 13)));
+	}
+
+	inline void i420ToBgr8(uint8x8_t y, int16x8_t d, int16x8_t e, uint8_t* bgr)
+	{
+		const int16x8_t ys = vreinterpretq_s16_u16(vsubl_u8(y, vdup_n_u8(16)));
+		const int16x4_t y_lo = vget_low_s16(ys), y_hi = vget_high_s16(ys);
+		const int16x4_t d_lo = vget_low_s16(d), d_hi = vget_high_s16(d);
+		const int16x4_t e_lo = vget_low_s16(e), e_hi = vget_high_s16(e);
+		const int32x4_t c_lo = vmull_n_s16(y_lo, COEF_Y), c_hi = vmull_n_s16(y_hi, COEF_Y);
+
+		uint8x8x3_t out;
+		out.val[0] = narrowQ13(vmlal_n_s16(c_lo, d_lo, COEF_BU), vmlal_n_s16(c_hi, d_hi, COEF_BU));
+		out.val[1] = narrowQ13(vmlsl_n_s16(vmlsl_n_s16(c_lo, d_lo, COEF_GU), e_lo, COEF_GV),
+			vmlsl_n_s16(vmlsl_n_s16(c_hi, d_hi, COEF_GU), e_hi, COEF_GV));
+		out.val[2] = narrowQ13(vmlal_n_s16(c_lo, e_lo, COEF_RV), vmlal_n_s16(c_hi, e_hi, COEF_RV));
+		vst3_u8(bgr, out);
+	}
+
+	inline size_t i420ToBgrRowNeon(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgr, size_t count)
+	{
+		const uint8x8_t bias = vdup_n_u8(128);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const uint8x16_t yy = vld1q_u8(y + i);
+			const int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(u + i / 2), bias));
+			const int16x8_t e = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(v + i / 2), bias));
+
+			// each chroma sample covers two pixels
+			const int16x8x2_t dd = vzipq_s16(d, d);
+			const int16x8x2_t ee = vzipq_s16(e, e);
+			i420ToBgr8(vget_low_u8(yy), dd.val[0], ee.val[0], bgr + i * 3);
+			i420ToBgr8(vget_high_u8(yy), dd.val[1], ee.val[1], bgr + i * 3 + 24);
+		}
+		return i;
+	}
+
+	inline size_t bgrToGreyRowNeon(const uint8_t* bgr, uint8_t* grey, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const uint8x8x3_t p = vld3_u8(bgr + i * 3);
+			uint16x8_t x = vmull_u8(p.val[0], vdup_n_u8(25));
+			x = vmlal_u8(x, p.val[1], vdup_n_u8(129));
+			x = vmlal_u8(x, p.val[2], vdup_n_u8(66));
+			vst1_u8(grey + i, vadd_u8(vrshrn_n_u16(x, 8), vdup_n_u8(16)));
+		}
+		return i;
+	}
+
+	inline size_t bgrToUvRowNeon(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v, size_t count)
+	{
+		const int16x8_t bias = vdupq_n_s16(128);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const uint8x16x3_t p0 = vld3q_u8(row0 + i * 3);
+			const uint8x16x3_t p1 = vld3q_u8(row1 + i * 3);
+
+			// 2x2 block averages
+			const int16x8_t b = vreinterpretq_s16_u16(vrshrq_n_u16(vaddq_u16(vpaddlq_u8(p0.val[0]), vpaddlq_u8(p1.val[0])), 2));
+			const int16x8_t g = vreinterpretq_s16_u16(vrshrq_n_u16(vaddq_u16(vpaddlq_u8(p0.val[1]), vpaddlq_u8(p1.val[1])), 2));
+			const int16x8_t r = vreinterpretq_s16_u16(vrshrq_n_u16(vaddq_u16(vpaddlq_u8(p0.val[2]), vpaddlq_u8(p1.val[2])), 2));
+
+			int16x8_t uu = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, -38), g, -74), b, 112);
+			int16x8_t vv = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, 112), g, -94), b, -18);
+			vst1_u8(u + i / 2, vqmovun_s16(vaddq_s16(vrshrq_n_s16(uu, 8), bias)));
+			vst1_u8(v + i / 2, vqmovun_s16(vaddq_s16(vrshrq_n_s16(vv, 8), bias)));
+		}
+		return i;
+	}
+#endif
+
+	/**
+	 * @brief Convert one row of YUV420 to packed BGR.
+	 *
+	 * @param y Luma row (count bytes).
+	 * @param u Cb row ((count + 1) / 2 bytes), shared by two luma rows.
+	 * @param v Cr row ((count + 1) / 2 bytes).
+	 * @param bgr Output row (count * 3 bytes).
+	 * @param count Number of pixels.
+	 */
+	inline void i420ToBgrRow(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* bgr, size_t count)
+	{
+		size_t done = 0;
+#if YUV_NEON
+		done = i420ToBgrRowNeon(y, u, v, bgr, count);
+#endif
+		i420ToBgrRowScalar(y + done, u + done / 2, v + done / 2, bgr + done * 3, count - done);
+	}
+
+	/**
+	 * @brief Convert one row of packed BGR to luma.
+	 */
+	inline void bgrToGreyRow(const uint8_t* bgr, uint8_t* grey, size_t count)
+	{
+		size_t done = 0;
+#if YUV_NEON
+		done = bgrToGreyRowNeon(bgr, grey, count);
+#endif
+		bgrToGreyRowScalar(bgr + done * 3, grey + done, count - done);
+	}
+
+	/**
+	 * @brief Chroma of two packed BGR rows (count / 2 Cb and Cr samples).
+	 */
+	inline void bgrToUvRow(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v, size_t count)
+	{
+		size_t done = 0;
+#if YUV_NEON
+		done = bgrToUvRowNeon(row0, row1, u, v, count);
+#endif
+		bgrToUvRowScalar(row0 + done * 3, row1 + done * 3, u + done / 2, v + done / 2, count - done);
+	}
+
+	/**
+	 * @brief Convert a YUV420 frame to packed BGR.
+	 *
+	 * @param y Luma plane.
+	 * @param y_stride Luma row pitch in bytes.
+	 * @param u Cb plane.
+	 * @param v Cr plane.
+	 * @param uv_stride Chroma row pitch in bytes.
+	 * @param bgr Output frame.
+	 * @param bgr_stride Output row pitch in bytes.
+	 * @param width Frame width (odd widths and heights take the chroma rounded up).
+	 * @param height Frame height.
+	 */
+	inline void i420ToBgr(const uint8_t* y, size_t y_stride, const uint8_t* u, const uint8_t* v, size_t uv_stride,
+		uint8_t* bgr, size_t bgr_stride, size_t width, size_t height)
+	{
+		for (size_t r = 0; r < height; r++)
+			i420ToBgrRow(y + y_stride * r, u + uv_stride * (r / 2), v + uv_stride * (r / 2), bgr + bgr_stride * r, width);
+	}
+
+	/**
+	 * @brief Convert a packed BGR frame to YUV420 planes.
+	 */
+	inline void bgrToI420(const uint8_t* bgr, size_t bgr_stride, uint8_t* y, size_t y_stride,
+		uint8_t* u, uint8_t* v, size_t uv_stride, size_t width, size_t height)
+	{
+		for (size_t r = 0; r + 1 < height; r += 2)
+		{
+			const uint8_t* row0 = bgr + bgr_stride * r;
+			bgrToGreyRow(row0, y + y_stride * r, width);
+			bgrToGreyRow(row0 + bgr_stride, y + y_stride * (r + 1), width);
+			bgrToUvRow(row0, row0 + bgr_stride, u + uv_stride * (r / 2), v + uv_stride * (r / 2), width);
+		}
+	}
+
+	/**
+	 * @brief Convert a packed BGR frame to luma.
+	 */
+	inline void bgrToGrey(const uint8_t* bgr, size_t bgr_stride, uint8_t* grey, size_t grey_stride,
+		size_t width, size_t height)
+	{
+		for (size_t r = 0; r < height; r++)
+			bgrToGreyRow(bgr + bgr_stride * r, grey + grey_stride * r, width);
+	}
+
+	/**
+	 * @brief Copy a plane row by row (strides may differ).
+	 */
+	inline void copyPlane(const uint8_t* src, size_t src_stride, uint8_t* dst, size_t dst_stride,
+		size_t width, size_t height)
+	{
+		for (size_t r = 0; r < height; r++)
+			memcpy(dst + dst_stride * r, src + src_stride * r, width);
+	}
+};
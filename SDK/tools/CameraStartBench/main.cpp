@@ -0,0 +1,209 @@
+/**
+ * @file CameraStartBench/main.cpp
+ * @brief Time to the first usable video frame for cold, warm and seeded starts.
+ *
+ * Starts and stops PiCameraStream video repeatedly in three modes:
+ * - cold   : the camera is opened and configured by every startVideo()
+ * - warm   : standby keeps the camera acquired and configured (setStandby())
+ * - seeded : warm, and AE/AWB start from the last converged values (setSeedExposure())
+ *
+ * Each mode is primed with one start that is not counted (it opens the camera for
+ * warm, and converges the values the seeded starts begin from). Reports, from the
+ * startVideo() call, the time until the camera runs, until the first frame and until
+ * the first AE-locked frame (see PiCameraStream::lastStart()), as mean and max in ms.
+ *
+ * Then times a still photo during video until the next video frame, against the
+ * stopVideo() / startPhoto() / capturePhoto() / startVideo() sequence plain PiCamera
+ * needs (cold, like the first mode). Point the camera at a steady scene.
+ *
+ * Usage:
+ *   CameraStartBench [--starts N] [--size WxH] [--pause MS]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "PiCameraStream.h"
+
+struct ModeResult
+{
+	const char* name;
+	bool standby;
+	bool seed;
+	double setup_ms = 0, first_ms = 0, usable_ms = 0;
+	double max_setup_ms = 0, max_first_ms = 0, max_usable_ms = 0;
+	int starts = 0;
+	int unlocked = 0;	// no AE-locked frame within the wait
+};
+
+static void printUsage()
+{
+	spdlog::info("Usage: CameraStartBench [--starts N] [--size WxH] [--pause MS]");
+}
+
+// one start: wait for the first usable frame (up to 5 s), then stop
+static bool timeStart(PiCameraStream& camera, VideoStartInfo& info)
+{
+	if (!camera.startVideo())
+		return false;
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	do
+	{
+		info = camera.lastStart();
+		if (info.usable_ns >= 0)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	camera.stopVideo();
+	return true;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// one still while video runs: in video, then by restarting video around a photo
+static bool timeStill(PiCameraStream& camera, double& in_video_ms, double& restart_ms)
+{
+	const unsigned int timeout_ms = 1500;
+	cv::Mat still, frame;
+	if (!camera.startVideo() || !camera.getVideoFrame(frame, timeout_ms))
+	{
+		camera.stopVideo();
+		return false;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	bool ok = camera.capturePhoto(still) && camera.getVideoFrame(frame, timeout_ms);
+	in_video_ms = elapsedMs(t0);
+
+	t0 = std::chrono::steady_clock::now();
+	camera.stopVideo();
+	ok = camera.startPhoto() && camera.capturePhoto(still) && ok;
+	camera.stopPhoto();
+	ok = camera.startVideo() && camera.getVideoFrame(frame, timeout_ms) && ok;
+	restart_ms = elapsedMs(t0);
+
+	camera.stopVideo();
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	int starts = 10;
+	unsigned int width = 640, height = 480;
+	int pause_ms = 500;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--starts") == 0 && i + 1 < argc)
+			starts = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%ux%u", &width, &height) != 2)
+			{
+				printUsage();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--pause") == 0 && i + 1 < argc)
+			pause_ms = atoi(argv[++i]);
+		else
+		{
+			printUsage();
+			return -1;
+		}
+	}
+
+	if (starts < 1)
+		starts = 1;
+
+	PiCameraStream camera;
+	camera.options->video_width = width;
+	camera.options->video_height = height;
+
+	ModeResult results[] = { { "cold", false, false }, { "warm", true, false }, { "seeded", true, true } };
+	for (auto& r : results)
+	{
+		camera.setStandby(r.standby);
+		camera.setSeedExposure(r.seed);
+
+		VideoStartInfo info;
+		if (!timeStart(camera, info))
+		{
+			spdlog::error("{}: startVideo() failed", r.name);
+			return -1;
+		}
+
+		for (int i = 0; i < starts; i++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms));
+			if (!timeStart(camera, info))
+			{
+				spdlog::error("{}: startVideo() failed", r.name);
+				return -1;
+			}
+
+			const double setup = info.setup_ns / 1e6, first = info.first_frame_ns / 1e6, usable = info.usable_ns / 1e6;
+			r.starts++;
+			r.setup_ms += setup;
+			r.first_ms += first;
+			r.max_setup_ms = std::max(r.max_setup_ms, setup);
+			r.max_first_ms = std::max(r.max_first_ms, first);
+			if (info.usable_ns < 0)
+			{
+				r.unlocked++;
+				continue;
+			}
+			r.usable_ms += usable;
+			r.max_usable_ms = std::max(r.max_usable_ms, usable);
+		}
+	}
+
+	camera.setStandby(false);
+	camera.setSeedExposure(false);
+	double still_ms = 0, restart_ms = 0, max_still_ms = 0, max_restart_ms = 0;
+	int stills = 0;
+	for (int i = 0; i < starts; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms));
+		double in_video, restart;
+		if (!timeStill(camera, in_video, restart))
+		{
+			spdlog::warn("still switch {} failed", i + 1);
+			continue;
+		}
+		stills++;
+		still_ms += in_video;
+		restart_ms += restart;
+		max_still_ms = std::max(max_still_ms, in_video);
+		max_restart_ms = std::max(max_restart_ms, restart);
+	}
+	camera.releaseCamera();
+
+	spdlog::info("{}x{}, {} start(s) per mode, ms from startVideo() (mean / max)", width, height, starts);
+	spdlog::info("mode         setup    first frame   usable frame  not locked");
+	for (const auto& r : results)
+	{
+		const int locked = r.starts - r.unlocked;
+		spdlog::info("{:<6} {:>6.1f}/{:<6.1f} {:>6.1f}/{:<6.1f} {:>6.1f}/{:<6.1f} {:>6}", r.name,
+			r.setup_ms / r.starts, r.max_setup_ms, r.first_ms / r.starts, r.max_first_ms,
+			locked > 0 ? r.usable_ms / locked : 0.0, r.max_usable_ms, r.unlocked);
+	}
+
+	if (stills > 0)
+	{
+		spdlog::info("{}x{} still, {} switch(es), ms until the next video frame (mean / max)",
+			camera.options->photo_width, camera.options->photo_height, stills);
+		spdlog::info("still during video {:>6.1f}/{:<6.1f} stop/start video {:>6.1f}/{:<6.1f}",
+			still_ms / stills, max_still_ms, restart_ms / stills, max_restart_ms);
+	}
+	return 0;
+}
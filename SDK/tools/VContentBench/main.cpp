@@ -0,0 +1,303 @@
+/**
+ * @file VContentBench/main.cpp
+ * @brief Load time benchmark for the VContent image formats.
+ *
+ * Converts every PNG below a directory (default /.doly/images) to QOI, PAM and `.vcb`
+ * in a temporary directory created below the scratch directory (default /tmp) and
+ * removed at exit, then loads each file of each format several times with
+ * VContent::getImageInto() and reports size and load time per format. `png lib` is
+ * VContent::getImage() on the same PNG: the decoded frames of every format, the PNG row
+ * decoder (VContentFormat::loadPng()) included, are compared with it (all formats are
+ * lossless), both 8-bit and 12-bit.
+ *
+ * A second table reports load time per megapixel for 8-bit and 16-bit sources
+ * (PNG as found, plus 8/16-bit PAM copies of each asset), with and without the fused
+ * premultiply + 12-bit pass, and the fused row kernel against its scalar reference
+ * (see VPixelKernels.h).
+ *
+ * Files are read from the page cache after the first run, so the numbers are decode
+ * cost; run on the robot for representative results.
+ *
+ * Usage:
+ *   VContentBench [directory] [--runs N] [--12bit] [--scratch DIR]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "VContent.h"
+#include "VContentFormats.h"
+#include "VContentMap.h"
+#include "VPixelKernels.h"
+
+struct FormatResult
+{
+	const char* name;
+	uint64_t bytes = 0;
+	uint64_t total_us = 0;
+	uint32_t loads = 0;
+	uint32_t mismatches = 0;
+};
+
+struct DepthResult
+{
+	const char* name;
+	uint64_t total_us = 0;
+	uint64_t pixels = 0;
+};
+
+static void printUsage()
+{
+	spdlog::info("Usage: VContentBench [directory] [--runs N] [--12bit] [--scratch DIR]");
+}
+
+// best-of-N load time in microseconds, 0 on failure
+static uint64_t timeLoad(const std::string& path, const VContentLoadOptions& options, int runs, VContent& content)
+{
+	uint64_t best = 0;
+	for (int r = 0; r < runs; r++)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		bool ok = VContent::getImageInto(content, path, options);
+		auto t1 = std::chrono::steady_clock::now();
+		if (!ok)
+			return 0;
+
+		uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+		if (r == 0 || us < best)
+			best = us;
+	}
+	return best == 0 ? 1 : best;
+}
+
+static uint64_t timeLoad(const std::string& path, bool rgba, bool set12Bit, int runs, VContent& content)
+{
+	VContentLoadOptions options;
+	options.isRGBA = rgba;
+	options.set12Bit = set12Bit;
+	return timeLoad(path, options, runs, content);
+}
+
+// same with the library PNG decoder, VContent::getImage()
+static uint64_t timeImage(const std::string& path, bool rgba, bool set12Bit, int runs, VContent& content)
+{
+	uint64_t best = 0;
+	for (int r = 0; r < runs; r++)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		content = VContent::getImage(path, rgba, set12Bit);
+		auto t1 = std::chrono::steady_clock::now();
+		if (!content.isReady())
+			return 0;
+
+		uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+		if (r == 0 || us < best)
+			best = us;
+	}
+	return best == 0 ? 1 : best;
+}
+
+// 16-bit PAM copy of an 8-bit frame (each sample widened to v * 257, big-endian)
+static bool writePam16(const VContent& content, const std::string& path)
+{
+	const uint8_t channels = content.alpha ? 4 : 3;
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL 65535\nTUPLTYPE %s\nENDHDR\n",
+		(unsigned)content.width, (unsigned)content.height, (unsigned)channels, content.alpha ? "RGB_ALPHA" : "RGB");
+
+	std::vector<uint8_t> wide(content.frames[0].size() * 2);
+	for (size_t i = 0; i < content.frames[0].size(); i++)
+		wide[i * 2] = wide[i * 2 + 1] = content.frames[0][i];
+
+	bool ok = fwrite(wide.data(), 1, wide.size(), file) == wide.size();
+	return fclose(file) == 0 && ok;
+}
+
+// best-of-N time of one pass over a 16-bit RGBA buffer, in microseconds
+template <typename Kernel>
+static uint64_t timeKernel(Kernel kernel, const std::vector<uint8_t>& src, std::vector<uint8_t>& dst,
+	size_t width, size_t height, int runs)
+{
+	uint64_t best = 0;
+	for (int r = 0; r < runs; r++)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t y = 0; y < height; y++)
+			kernel(src.data() + width * 8 * y, 4, true, dst.data() + width * 4 * y, 4, width, VPIXEL_PREMULTIPLY | VPIXEL_12BIT);
+		auto t1 = std::chrono::steady_clock::now();
+
+		uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+		if (r == 0 || us < best)
+			best = us;
+	}
+	return best == 0 ? 1 : best;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string directory = "/.doly/images";
+	std::string scratch = "/tmp";
+	bool set12Bit = false;
+	int runs = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--12bit") == 0)
+			set12Bit = true;
+		else if (strcmp(argv[i], "--scratch") == 0 && i + 1 < argc)
+			scratch = argv[++i];
+		else if (argv[i][0] != '-')
+			directory = argv[i];
+		else
+		{
+			printUsage();
+			return -1;
+		}
+	}
+
+	if (runs < 1)
+		runs = 1;
+
+	// only this directory is removed at exit, never the one given by --scratch
+	std::error_code ec;
+	std::filesystem::create_directories(scratch, ec);
+	std::string temp = scratch + "/vcontent_bench.XXXXXX";
+	if (ec || mkdtemp(&temp[0]) == nullptr)
+	{
+		spdlog::error("Cannot create a directory in {}", scratch);
+		return -2;
+	}
+
+	FormatResult results[] = { { "png lib" }, { "png" }, { "qoi" }, { "pam" }, { "vcb" } };
+	DepthResult depths[] = { { "png 8-bit" }, { "png 16-bit" }, { "pam 8-bit" }, { "pam 16-bit" },
+		{ "pam 8-bit +pm" }, { "pam 16-bit +pm" } };
+	uint64_t pixels = 0;
+	int files = 0;
+
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, ec);
+		!ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		if (!it->is_regular_file() || it->path().extension() != ".png")
+			continue;
+
+		VImageInfo info;
+		const std::string png = it->path().string();
+		if (!VContentFormat::probe(png, info) || info.format != VImageFormat::PNG)
+			continue;
+
+		// reference: getImage() in the timed mode; other: getImage() in the other color
+		// depth, files are written from the 8-bit one
+		const bool rgba = info.channels == 4;
+		VContent reference, other;
+		uint64_t lib_us = timeImage(png, rgba, set12Bit, runs, reference);
+		other = VContent::getImage(png, rgba, !set12Bit);
+		if (lib_us == 0 || !other.isReady())
+		{
+			spdlog::warn("Load failed: {}", png);
+			continue;
+		}
+
+		const VContent& plain = set12Bit ? other : reference;
+		const std::string base = temp + "/" + std::to_string(files);
+		const std::string paths[] = { png, png, base + ".qoi", base + ".pam", base + ".vcb" };
+		if (VContentFormat::saveQoi(plain, paths[2]) != 0 || VContentFormat::savePam(plain, paths[3]) != 0
+			|| VContentFile::save(plain, paths[4]) != 0)
+		{
+			spdlog::error("Write to scratch directory failed: {}", temp);
+			std::filesystem::remove_all(temp, ec);
+			return -3;
+		}
+
+		results[0].total_us += lib_us;
+		uint64_t png_us = 0;
+		for (size_t f = 0; f < 5; f++)
+		{
+			results[f].bytes += std::filesystem::file_size(paths[f], ec);
+			results[f].loads++;
+			if (f == 0)
+				continue;
+
+			VContent content;
+			uint64_t us = timeLoad(paths[f], rgba, set12Bit, runs, content);
+			results[f].total_us += us;
+			if (f == 1)
+				png_us = us;
+			if (us == 0 || content.frames != reference.frames)
+				results[f].mismatches++;
+			else if (!VContent::getImageInto(content, paths[f], rgba, !set12Bit) || content.frames != other.frames)
+				results[f].mismatches++;
+		}
+
+		// 8/16-bit sources, plain and with the fused premultiply pass (RGBA only)
+		const uint64_t frame_pixels = (uint64_t)reference.width * reference.height;
+		depths[info.bit_depth == 16 ? 1 : 0].total_us += png_us;
+		depths[info.bit_depth == 16 ? 1 : 0].pixels += frame_pixels;
+		if (plain.frames.size() == 1 && writePam16(plain, base + "_16.pam"))
+		{
+			const std::string sources[] = { paths[3], base + "_16.pam" };
+			for (int premultiply = 0; premultiply <= (rgba ? 1 : 0); premultiply++)
+			{
+				VContentLoadOptions options;
+				options.isRGBA = rgba;
+				options.set12Bit = set12Bit;
+				options.premultiply = premultiply != 0;
+				for (int wide = 0; wide < 2; wide++)
+				{
+					VContent content;
+					DepthResult& d = depths[2 + premultiply * 2 + wide];
+					d.total_us += timeLoad(sources[wide], options, runs, content);
+					d.pixels += frame_pixels;
+				}
+			}
+		}
+
+		pixels += frame_pixels * reference.frames.size();
+		files++;
+	}
+
+	std::filesystem::remove_all(temp, ec);
+	if (files == 0)
+	{
+		spdlog::error("No RGB/RGBA PNG files found in {}", directory);
+		return -2;
+	}
+
+	const double megapixels = (double)pixels / 1e6;
+	spdlog::info("{} file(s), {:.2f} MP, best of {} run(s){}", files, megapixels, runs, set12Bit ? ", 12-bit" : "");
+	spdlog::info("format      size KB   total ms   us/file    ms/MP   vs lib");
+	for (const auto& r : results)
+	{
+		spdlog::info("{:<7} {:>11.1f} {:>10.2f} {:>9.0f} {:>8.2f} {:>7.2f}x{}", r.name,
+			r.bytes / 1024.0, r.total_us / 1000.0, (double)r.total_us / r.loads,
+			r.total_us / 1000.0 / megapixels, (double)results[0].total_us / (double)(r.total_us ? r.total_us : 1),
+			r.mismatches ? fmt::format("  ({} mismatch)", r.mismatches) : "");
+	}
+
+	spdlog::info("source                  MP     ms/MP");
+	for (const auto& d : depths)
+	{
+		if (d.pixels != 0)
+			spdlog::info("{:<16} {:>9.2f} {:>9.2f}", d.name, d.pixels / 1e6, d.total_us / 1000.0 / (d.pixels / 1e6));
+	}
+
+	// row kernel alone: 16-bit RGBA -> premultiplied 12-bit RGBA, 1 MP
+	const size_t kw = 1000, kh = 1000;
+	std::vector<uint8_t> src(kw * kh * 8), dst(kw * kh * 4);
+	for (size_t i = 0; i < src.size(); i++)
+		src[i] = (uint8_t)(i * 31 + (i >> 8));
+	uint64_t scalar_us = timeKernel(VPixelKernels::convertRowScalar, src, dst, kw, kh, runs);
+	uint64_t fused_us = timeKernel(VPixelKernels::convertRow, src, dst, kw, kh, runs);
+	spdlog::info("row kernel 16-bit RGBA +pm +12bit: scalar {:.2f} ms/MP, fused{} {:.2f} ms/MP",
+		scalar_us / 1000.0, VPIXEL_NEON ? " (NEON)" : "", fused_us / 1000.0);
+	return 0;
+}
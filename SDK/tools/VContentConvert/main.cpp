@@ -0,0 +1,267 @@
+/**
+ * @file VContentConvert/main.cpp
+ * @brief Image to `.vcb` / QOI / PAM converter.
+ *
+ * Decodes an image once with VContent::getImageInto() and stores it in a faster
+ * loading format, chosen by the output extension:
+ * - `.vcb` : raw frames in the `.vcb` container (see VContentMap.h), loaded with
+ *            VContent::map() without any decoding
+ * - `.qoi` : QOI compressed, about PNG size, decodes several times faster (see VContentFormats.h)
+ * - `.pam` : uncompressed PAM, read straight into the frame buffer
+ *
+ * Several inputs, or a printf-style pattern with --frames, are decoded as one animation
+ * (one PNG per frame, see VContentLoader::loadSequence()) into a multi-frame `.vcb` file.
+ *
+ * With --lcd12/--lcd18 the `.vcb` frames are stored pre-converted in the LCD buffer
+ * format (see VLcdContent.h); this initializes LcdControl for the conversion.
+ *
+ * With --batch every PNG below a directory (e.g. /.doly/images) is converted next to
+ * its source file; RGB/RGBA is taken from each PNG header.
+ *
+ * Usage:
+ *   VContentConvert <input> <output.vcb|.qoi|.pam> [--rgba] [--12bit] [--ratio N] [--loop N] [--lcd12 | --lcd18]
+ *   VContentConvert <frame> <frame> ... <output.vcb> [options]
+ *   VContentConvert <pattern, e.g. intro/%03d.png> <output.vcb> --frames N [--first N] [options]
+ *   VContentConvert --batch <directory> <vcb|qoi|pam> [--12bit] [--ratio N] [--loop N]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "VContent.h"
+#include "LcdControl.h"
+#include "VContentFormats.h"
+#include "VContentLoader.h"
+#include "VContentMap.h"
+#include "VLcdContent.h"
+
+struct ConvertOptions
+{
+	bool rgba = false;
+	bool set12Bit = false;
+	int ratio = -1;
+	int loop = -1;
+	int lcd = 0;
+	int frames = 0;		// > 0: the input is a frame pattern
+	int first = 0;
+};
+
+static void printUsage()
+{
+	spdlog::info("Usage: VContentConvert <input> <output.vcb|.qoi|.pam> [--rgba] [--12bit] [--ratio N] [--loop N] [--lcd12 | --lcd18]");
+	spdlog::info("       VContentConvert <frame> <frame> ... <output.vcb> [options]");
+	spdlog::info("       VContentConvert <pattern, e.g. intro/%03d.png> <output.vcb> --frames N [--first N] [options]");
+	spdlog::info("       VContentConvert --batch <directory> <vcb|qoi|pam> [--12bit] [--ratio N] [--loop N]");
+}
+
+static bool hasExtension(const std::string& path, const char* ext)
+{
+	const size_t len = strlen(ext);
+	return path.size() > len && path.compare(path.size() - len, len, ext) == 0;
+}
+
+// one input: any format VContent::getImageInto() reads; several: one PNG per frame
+static int convertFiles(const std::vector<std::string>& inputs, const std::string& output, const ConvertOptions& options)
+{
+	const std::string input = inputs.size() == 1 ? inputs[0] : inputs[0] + " ... " + inputs.back();
+	auto t0 = std::chrono::steady_clock::now();
+	VContent content;
+	if (inputs.size() == 1)
+		VContent::getImageInto(content, inputs[0], options.rgba, options.set12Bit);
+	else
+		content = VContentLoader::loadSequence(inputs, options.rgba, options.set12Bit).get();
+	auto t1 = std::chrono::steady_clock::now();
+	if (!content.isReady())
+	{
+		spdlog::error("Load failed: {}", input);
+		return -2;
+	}
+
+	// getImage() does not take these, allow setting them per file
+	if (options.ratio > 0)
+		content.ratio = (uint8_t)options.ratio;
+	if (options.loop >= 0)
+		content.loop = (uint16_t)options.loop;
+
+	int8_t saved;
+	if (options.lcd != 0)
+	{
+		if (LcdControl::init(options.lcd == 12 ? LcdColorDepth::L12BIT : LcdColorDepth::L18BIT) < 0)
+		{
+			spdlog::error("LcdControl init failed");
+			return -3;
+		}
+
+		VLcdContent lcd_content;
+		if (lcd_content.assign(content) != 0)
+		{
+			spdlog::error("LCD conversion failed, content must be full-panel sized");
+			LcdControl::dispose();
+			return -3;
+		}
+
+		saved = lcd_content.save(output);
+		LcdControl::dispose();
+	}
+	else if (hasExtension(output, ".qoi"))
+		saved = VContentFormat::saveQoi(content, output);
+	else if (hasExtension(output, ".pam"))
+		saved = VContentFormat::savePam(content, output);
+	else
+		saved = VContentFile::save(content, output);
+
+	if (saved != 0)
+	{
+		spdlog::error("Save failed: {}", output);
+		return -3;
+	}
+
+	// verify and compare load times
+	auto t2 = std::chrono::steady_clock::now();
+	bool verified;
+	if (options.lcd != 0)
+		verified = VContent::map(output).isReady();
+	else
+	{
+		VContent check;
+		verified = VContent::getImageInto(check, output, options.rgba, options.set12Bit);
+	}
+	auto t3 = std::chrono::steady_clock::now();
+	if (!verified)
+	{
+		spdlog::error("Verify failed: {}", output);
+		return -4;
+	}
+
+	spdlog::info("{} -> {} ({}x{}, {} frame(s)), load: {} us -> {} us", input, output,
+		content.width, content.height, content.frames.size(),
+		std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count(),
+		std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count());
+
+	return 0;
+}
+
+static int convertDirectory(const std::string& directory, const std::string& format, ConvertOptions options)
+{
+	if (format != "vcb" && format != "qoi" && format != "pam")
+	{
+		printUsage();
+		return -1;
+	}
+
+	std::error_code ec;
+	int converted = 0, failed = 0;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, ec);
+		!ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		if (!it->is_regular_file() || it->path().extension() != ".png")
+			continue;
+
+		VImageInfo info;
+		const std::string input = it->path().string();
+		if (!VContentFormat::probe(input, info) || info.format != VImageFormat::PNG)
+		{
+			spdlog::warn("Skipped, not an RGB/RGBA PNG: {}", input);
+			failed++;
+			continue;
+		}
+
+		options.rgba = info.channels == 4;
+		std::filesystem::path output = it->path();
+		output.replace_extension(format);
+		if (convertFiles({ input }, output.string(), options) == 0)
+			converted++;
+		else
+			failed++;
+	}
+
+	if (ec)
+	{
+		spdlog::error("Directory read failed: {} ({})", directory, ec.message());
+		return -2;
+	}
+
+	spdlog::info("Converted {} file(s), {} failed", converted, failed);
+	return failed == 0 ? 0 : -3;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printUsage();
+		return -1;
+	}
+
+	const bool batch = strcmp(argv[1], "--batch") == 0;
+	if (batch && argc < 4)
+	{
+		printUsage();
+		return -1;
+	}
+
+	// positional arguments: inputs, then the output
+	ConvertOptions options;
+	std::vector<std::string> files;
+	for (int i = batch ? 4 : 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--rgba") == 0 && !batch)
+			options.rgba = true;
+		else if (strcmp(argv[i], "--12bit") == 0)
+			options.set12Bit = true;
+		else if (strcmp(argv[i], "--ratio") == 0 && i + 1 < argc)
+			options.ratio = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--loop") == 0 && i + 1 < argc)
+			options.loop = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--lcd12") == 0 && !batch)
+			options.lcd = 12;
+		else if (strcmp(argv[i], "--lcd18") == 0 && !batch)
+			options.lcd = 18;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && !batch)
+			options.frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--first") == 0 && i + 1 < argc && !batch)
+			options.first = atoi(argv[++i]);
+		else if (argv[i][0] != '-' && !batch)
+			files.push_back(argv[i]);
+		else
+		{
+			printUsage();
+			return -1;
+		}
+	}
+
+	if (batch)
+		return convertDirectory(argv[2], argv[3], options);
+
+	if (files.size() < 2 || (options.frames != 0 && files.size() != 2) || options.frames < 0 || options.frames > 0xffff)
+	{
+		printUsage();
+		return -1;
+	}
+
+	const std::string output = files.back();
+	files.pop_back();
+	if (options.frames > 0)
+	{
+		const std::string pattern = files[0];
+		files = VContentLoader::framePaths(pattern, (uint16_t)options.frames, options.first);
+		if (files.empty())
+		{
+			spdlog::error("Invalid frame pattern, expected one %d conversion: {}", pattern);
+			return -1;
+		}
+	}
+
+	if ((options.lcd != 0 || files.size() > 1) && !hasExtension(output, ".vcb"))
+	{
+		spdlog::error("--lcd12/--lcd18 and frame sequences require a .vcb output");
+		return -1;
+	}
+
+	return convertFiles(files, output, options);
+}